@@ -0,0 +1,135 @@
+#include "lib/batch.h"
+#include "util/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+namespace {
+void print_usage() {
+    std::cout << "Uso: batch [--jobs N] [--out DIR] [--k K] [--list ARQUIVO] entradas...\n"
+              << "  entradas: arquivos .ppm ou diretórios (todos os .ppm do diretório)\n"
+              << "  --jobs N       imagens processadas ao mesmo tempo (padrão: núcleos da máquina)\n"
+              << "  --out DIR      diretório de saída (padrão: segmented)\n"
+              << "  --k K          parâmetro de Felzenszwalb (padrão: 300)\n"
+              << "  --list ARQ     arquivo com um caminho de entrada por linha\n";
+}
+
+void add_input(const std::filesystem::path &path, std::vector<std::filesystem::path> &inputs) {
+    if (std::filesystem::is_directory(path)) {
+        std::vector<std::filesystem::path> found;
+        for (const auto &entry : std::filesystem::directory_iterator(path)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".ppm") {
+                found.push_back(entry.path());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        inputs.insert(inputs.end(), found.begin(), found.end());
+    } else {
+        inputs.push_back(path);
+    }
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t idx = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    return values[std::min(idx, values.size() - 1)];
+}
+}
+
+int main(int argc, char *argv[]) {
+    SegmentationParams params;
+    int jobs = 0;
+    std::filesystem::path out_dir = "segmented";
+    std::vector<std::filesystem::path> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--k") == 0 && i + 1 < argc) {
+            params.k = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+            std::ifstream list(argv[++i]);
+            std::string line;
+            while (std::getline(list, line)) {
+                if (!line.empty()) add_input(line, inputs);
+            }
+        } else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            print_usage();
+            return 0;
+        } else {
+            add_input(argv[i], inputs);
+        }
+    }
+
+    if (inputs.empty()) {
+        print_usage();
+        return 1;
+    }
+    std::filesystem::create_directories(out_dir);
+
+    // One workspace per worker: at most `jobs` images in flight, buffers reused between them
+    ThreadPool pool(jobs);
+    int workers = std::min(pool.size(), static_cast<int>(inputs.size()));
+    std::atomic<int> next_input{0};
+    std::atomic<int> failed{0};
+    std::mutex stats_mutex;
+    std::vector<std::vector<double>> stage_times(STAGE_COUNT);
+    std::vector<double> image_times;
+
+    auto worker = [&]() {
+        SegmentationWorkspace ws;
+        int idx;
+        while ((idx = next_input.fetch_add(1)) < static_cast<int>(inputs.size())) {
+            const std::filesystem::path &input = inputs[idx];
+            std::filesystem::path output = out_dir / (input.stem().string() + "_segmented.ppm");
+            if (!segment_file(input.string(), output.string(), params, ws)) {
+                std::cerr << "Falha ao processar " << input << "\n";
+                failed++;
+                continue;
+            }
+            double total = 0.0;
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            for (int s = 0; s < STAGE_COUNT; s++) {
+                stage_times[s].push_back(ws.stage_seconds[s]);
+                total += ws.stage_seconds[s];
+            }
+            image_times.push_back(total);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<void>> running;
+    for (int w = 1; w < workers; w++) {
+        running.push_back(pool.submit(worker));
+    }
+    worker();
+    for (auto &r : running) {
+        r.get();
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int done = static_cast<int>(image_times.size());
+    printf("Imagens: %d (%d falhas) | Workers: %d | Tempo total: %.3lfs | %.2lf imagens/s\n\n",
+           done, failed.load(), workers, wall, wall > 0 ? done / wall : 0.0);
+    printf("%-12s %10s %10s %10s %10s\n", "Etapa (ms)", "p50", "p90", "p99", "max");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        printf("%-12s %10.2lf %10.2lf %10.2lf %10.2lf\n", stage_name(s),
+               1000 * percentile(stage_times[s], 0.50), 1000 * percentile(stage_times[s], 0.90),
+               1000 * percentile(stage_times[s], 0.99), 1000 * percentile(stage_times[s], 1.0));
+    }
+    printf("%-12s %10.2lf %10.2lf %10.2lf %10.2lf\n", "total",
+           1000 * percentile(image_times, 0.50), 1000 * percentile(image_times, 0.90),
+           1000 * percentile(image_times, 0.99), 1000 * percentile(image_times, 1.0));
+
+    return failed.load() == 0 ? 0 : 1;
+}
@@ -1,12 +1,17 @@
 #include "graph/Graph.h"
+#include "graph/Generators.h"
+#include "graph/GraphLoaders.h"
 #include "util/Ppm.h"
 #include "lib/tarjan.h"
 #include "lib/gabow.h"
+#include "lib/edmonds.h"
+#include "lib/dynamic.h"
 #include <chrono>
 #include <cmath>
 #include <cstring>
 #include <iostream>
 #include <random>
+#include <string>
 
 namespace {
 void print_graph_info(const DirectedGraph &graph, int root) {
@@ -18,52 +23,32 @@ void print_graph_info(const DirectedGraph &graph, int root) {
     int missing_edges = 0;
     for (int v = 0; v < graph.vertex_count(); ++v) {
         if (v == root) continue;
-        auto sources = graph.get_sources_to(v);
-        if (sources.empty()) {
+        if (graph.in_degree(v) == 0) {
             missing_edges++;
         }
     }
     std::cout << "Vértices sem aresta de entrada: " << missing_edges << "\n";
 }
 
-DirectedGraph make_synthetic_graph(int vertices, int out_degree, uint32_t seed) {
-    DirectedGraph graph(vertices);
-    graph.add_all_vertices();
-    if (vertices == 0) {
-        return graph;
-    }
-
-    std::mt19937 rng(seed);
-    std::uniform_real_distribution<double> weight_dist(0.1, 10.0); // Custos positivos
-
-    // Garantir que cada vértice (exceto raiz) tenha pelo menos uma aresta de entrada
-    for (int v = 1; v < vertices; ++v) {
-        std::uniform_int_distribution<int> parent_dist(0, v - 1);
-        int parent = parent_dist(rng);
-        double weight = weight_dist(rng);
-        graph.connect(parent, v, weight);
-    }
-
-    // Adicionar arestas extras
-    for (int u = 0; u < vertices; ++u) {
-        int current_out = static_cast<int>(graph.get_destinations_from(u).size());
-        int desired = std::min(out_degree, vertices - 1);
-        
-        if (current_out >= desired) continue;
-
-        for (int v = 0; v < vertices; ++v) {
-            if (u == v) continue;
-            if (current_out >= desired) break;
-            
-            if (!graph.has_connection(u, v)) {
-                double weight = weight_dist(rng);
-                graph.connect(u, v, weight);
-                current_out++;
-            }
-        }
+// Grafo sintético de uma das famílias de graph/Generators.h, com ~vertices * out_degree arestas
+// "tree" (padrão) sempre tem arborescência a partir de 0; nas outras ela pode não existir
+graph_file::Csr make_synthetic_graph(const std::string& family, int vertices, int out_degree, uint64_t seed) {
+    int64_t edges = static_cast<int64_t>(vertices) * out_degree;
+    generators::EdgeArrays arrays;
+    if (family == "er") {
+        arrays = generators::erdos_renyi(vertices, edges, seed);
+    } else if (family == "rmat") {
+        int scale = std::max(1, static_cast<int>(std::ceil(std::log2(vertices))));
+        arrays = generators::rmat(scale, edges, seed);
+    } else if (family == "powerlaw") {
+        arrays = generators::power_law(vertices, edges, 2.1, seed);
+    } else if (family == "grid") {
+        int width = std::max(1, static_cast<int>(std::sqrt(vertices)));
+        arrays = generators::grid(width, (vertices + width - 1) / width, false, seed);
+    } else {
+        arrays = generators::arborescence(vertices, std::max<int64_t>(0, edges - (vertices - 1)), seed);
     }
-
-    return graph;
+    return generators::build_csr(arrays);
 }
 
 DirectedGraph create_simple_test_graph() {
@@ -79,6 +64,76 @@ DirectedGraph create_simple_test_graph() {
     
     return graph;
 }
+
+// Uma alteração dentro do ciclo {1, 2} tem de ser consertada sem recálculo
+bool check_cycle_repair() {
+    DirectedGraph graph(4);
+    graph.add_all_vertices();
+    graph.connect(0, 1, 10.0);
+    graph.connect(0, 2, 10.0);
+    graph.connect(1, 2, 1.0);
+    graph.connect(2, 1, 1.0);
+    graph.connect(2, 3, 1.0);
+    graph.connect(0, 3, 20.0);
+
+    DynamicArborescence dynamic(graph, 0);
+    const ArborescenceResult& tree = dynamic.result();
+    int v = tree.parent_of[1] == 2 ? 1 : 2;
+    dynamic.apply({DynamicArborescence::EdgeUpdate::set(tree.parent_of[v], v, 2.0)});
+    return !dynamic.last_was_recomputed() && std::abs(tree.total_tree_cost - 12.0) < 1e-9 &&
+           ArborescenceVerifier::certifies_minimum(dynamic.current_graph(), tree, tree.duals);
+}
+
+// --dynamic: muda o custo de arestas da árvore que estão dentro de ciclos contraídos e confere
+// cada resultado com um cálculo do zero e com o certificado dual
+bool check_dynamic_updates(const DirectedGraph& graph, int root, int updates, uint64_t seed) {
+    DynamicArborescence dynamic(graph, root);
+    const ArborescenceResult& tree = dynamic.result();
+    if (!tree.is_complete) {
+        std::cout << "Dinâmica: o grafo não tem arborescência a partir de " << root << "\n";
+        return true;
+    }
+    std::vector<int> candidates;
+    for (int v = 0; v < graph.vertex_count(); ++v) {
+        if (v != root) candidates.push_back(v);
+    }
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> change(-1.0, 1.0);
+    MinimumBranching reference;
+    int local = 0, recomputed = 0, wrong = 0;
+    double dynamic_ms = 0.0, fresh_ms = 0.0;
+    for (int i = 0; i < updates; ++i) {
+        int v = -1;
+        for (int tries = 0; tries < 100 && v == -1; ++tries) {
+            int w = candidates[rng() % candidates.size()];
+            if (tree.duals.cluster_parent[w] != -1 && tree.parent_of[w] != -1) v = w;
+        }
+        if (v == -1) break;
+
+        double cost = std::max(0.0, tree.edge_costs[v] + change(rng));
+        auto start = std::chrono::high_resolution_clock::now();
+        dynamic.apply({DynamicArborescence::EdgeUpdate::set(tree.parent_of[v], v, cost)});
+        auto middle = std::chrono::high_resolution_clock::now();
+        ArborescenceResult fresh = reference.find_arborescence(dynamic.current_graph(), root);
+        auto end = std::chrono::high_resolution_clock::now();
+        dynamic_ms += std::chrono::duration<double, std::milli>(middle - start).count();
+        fresh_ms += std::chrono::duration<double, std::milli>(end - middle).count();
+
+        (dynamic.last_was_recomputed() ? recomputed : local)++;
+        if (std::abs(fresh.total_tree_cost - tree.total_tree_cost) > 1e-6 * std::max(1.0, std::abs(fresh.total_tree_cost)) ||
+            !ArborescenceVerifier::certifies_minimum(dynamic.current_graph(), tree, tree.duals)) {
+            wrong++;
+        }
+    }
+
+    int done = local + recomputed;
+    std::cout << "Dinâmica: " << done << " alterações dentro de ciclos | locais: " << local
+              << " | recalculadas: " << recomputed << " | erradas: " << wrong << "\n";
+    if (done > 0) {
+        std::cout << "Tempo médio: " << dynamic_ms / done << "ms por alteração (do zero: " << fresh_ms / done << "ms)\n";
+    }
+    return wrong == 0;
+}
 }
 
 int main(int argc, char *argv[]) {
@@ -86,15 +141,22 @@ int main(int argc, char *argv[]) {
     int vertex_limit = 1000; // Reduzido para testes mais rápidos
     bool use_synthetic = false;
     bool use_image = false;
+    bool use_file = false;
     int synthetic_vertices = 10;
     int synthetic_out_degree = 3;
-    uint32_t synthetic_seed = 1337u;
+    uint64_t synthetic_seed = 1337u;
+    std::string synthetic_family = "tree";
+    std::string save_path;
+    std::string graph_path;
+    bool run_edmonds = false;
     bool use_simple_test = true;
+    int dynamic_updates = 0;
 
     for (int i = 1; i < argc; ++i) {
         if ((std::strcmp(argv[i], "--limit") == 0 || std::strcmp(argv[i], "-l") == 0) && i + 1 < argc) {
             vertex_limit = std::max(1, std::atoi(argv[++i]));
         } else if (std::strcmp(argv[i], "--synthetic") == 0 || std::strcmp(argv[i], "-s") == 0) {
+            use_file = false;
             use_synthetic = true;
             use_simple_test = false;
             use_image = false;
@@ -105,8 +167,23 @@ int main(int argc, char *argv[]) {
                 synthetic_out_degree = std::max(1, std::atoi(argv[++i]));
             }
         } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
-            synthetic_seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            synthetic_seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--family") == 0 && i + 1 < argc) {
+            synthetic_family = argv[++i];
+        } else if (std::strcmp(argv[i], "--save-graph") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--edmonds") == 0) {
+            run_edmonds = true;
+        } else if (std::strcmp(argv[i], "--dynamic") == 0 && i + 1 < argc) {
+            dynamic_updates = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--graph") == 0 && i + 1 < argc) {
+            use_file = true;
+            use_synthetic = false;
+            use_simple_test = false;
+            use_image = false;
+            graph_path = argv[++i];
         } else if (std::strcmp(argv[i], "--image") == 0) {
+            use_file = false;
             use_synthetic = false;
             use_simple_test = false;
             use_image = true;
@@ -122,9 +199,28 @@ int main(int argc, char *argv[]) {
         std::cout << "Usando grafo de teste simples...\n";
         graph = create_simple_test_graph();
     } else if (use_synthetic) {
-        std::cout << "Gerando grafo sintético com " << synthetic_vertices
+        std::cout << "Gerando grafo sintético (" << synthetic_family << ") com " << synthetic_vertices
                   << " vértices e " << synthetic_out_degree << " arestas por vértice\n";
-        graph = make_synthetic_graph(synthetic_vertices, synthetic_out_degree, synthetic_seed);
+        auto start_generate = std::chrono::high_resolution_clock::now();
+        graph_file::Csr csr = make_synthetic_graph(synthetic_family, synthetic_vertices, synthetic_out_degree, synthetic_seed);
+        graph = DirectedGraph::from_csr(csr);
+        auto end_generate = std::chrono::high_resolution_clock::now();
+        std::cout << "Geração: " << std::chrono::duration_cast<std::chrono::milliseconds>(end_generate - start_generate).count() << "ms\n";
+        if (!save_path.empty() && !graph_file::write(save_path, csr, false)) {
+            std::cerr << "Não foi possível gravar " << save_path << "\n";
+        }
+    } else if (use_file) {
+        // DIMACS (.gr), Matrix Market (.mtx) ou lista de arestas SNAP (demais extensões)
+        std::cout << "Carregando " << graph_path << "\n";
+        auto start_load = std::chrono::high_resolution_clock::now();
+        try {
+            graph = DirectedGraph::from_csr(graph_loaders::load_csr(graph_path));
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << "\n";
+            return 1;
+        }
+        auto end_load = std::chrono::high_resolution_clock::now();
+        std::cout << "Carregamento: " << std::chrono::duration_cast<std::chrono::milliseconds>(end_load - start_load).count() << "ms\n";
     } else if (use_image) {
         int width = 0, height = 0;
         std::vector<std::vector<std::vector<int>>> image;
@@ -135,25 +231,24 @@ int main(int argc, char *argv[]) {
         }
 
         auto smoothed = blurImg(image, width, height, 2);
-        WeightedGraph weighted = WeightedGraph::from_ppm_matrix(smoothed, width, height, 0.0);
+        ImageGraph weighted = ImageGraph::from_ppm_matrix(smoothed, width, height, 0.0);
         graph = DirectedGraph::from_weighted_graph(weighted);
         
         if (vertex_limit < graph.vertex_count()) {
             DirectedGraph limited(vertex_limit);
             limited.add_all_vertices();
             for (int u = 0; u < vertex_limit; ++u) {
-                auto destinations = graph.get_destinations_from(u);
-                for (const auto &entry : destinations) {
-                    if (entry.first < vertex_limit) {
-                        limited.connect(u, entry.first, entry.second);
+                graph.for_each_destination(u, [&](int v, double cost) {
+                    if (v < vertex_limit) {
+                        limited.connect(u, v, cost);
                     }
-                }
+                });
             }
             graph = limited;
             std::cout << "Grafo limitado para " << vertex_limit << " vértices\n";
         }
     } else {
-        std::cout << "Nenhum modo escolhido explicitamente; use --image ou --synthetic para outros testes.\n";
+        std::cout << "Nenhum modo escolhido explicitamente; use --image, --synthetic ou --graph para outros testes.\n";
         graph = create_simple_test_graph();
     }
 
@@ -175,6 +270,17 @@ int main(int argc, char *argv[]) {
     auto end_gabow = std::chrono::high_resolution_clock::now();
     auto gabow_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_gabow - start_gabow).count();
 
+    // Referência exata (--edmonds): Chu-Liu/Edmonds com as fases de cada nível no pool de threads
+    ArborescenceResult edmonds_result(0, root_vertex);
+    long long edmonds_time = 0;
+    if (run_edmonds) {
+        EdmondsAlgorithm edmonds(&ThreadPool::shared());
+        auto start_edmonds = std::chrono::high_resolution_clock::now();
+        edmonds_result = edmonds.find_minimum_cost_arborescence(graph, root_vertex);
+        auto end_edmonds = std::chrono::high_resolution_clock::now();
+        edmonds_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_edmonds - start_edmonds).count();
+    }
+
     std::cout << "\n=== RESULTADOS ===\n";
     std::cout << "Tarjan: " << (tarjan_result.is_complete ? "SUCESSO" : "FALHA")
               << " | Custo: " << tarjan_result.total_tree_cost
@@ -184,6 +290,15 @@ int main(int argc, char *argv[]) {
               << " | Custo: " << gabow_result.total_tree_cost
               << " | Tempo: " << gabow_time << "ms\n";
 
+    if (run_edmonds) {
+        std::cout << "Edmonds: " << (edmonds_result.is_complete ? "SUCESSO" : "FALHA")
+                  << " | Custo: " << edmonds_result.total_tree_cost
+                  << " | Tempo: " << edmonds_time << "ms (" << ThreadPool::shared().size() << " threads)\n";
+    }
+
+    std::cout << "Verificação: Tarjan " << (ArborescenceVerifier::is_valid(graph, tarjan_result) ? "válida" : "inválida")
+              << " | Gabow " << (ArborescenceVerifier::is_valid(graph, gabow_result) ? "válida" : "inválida") << "\n";
+
     if (tarjan_result.is_complete && gabow_result.is_complete) {
         double diff = std::abs(tarjan_result.total_tree_cost - gabow_result.total_tree_cost);
         std::cout << "Diferença de custo: " << diff << "\n";
@@ -196,5 +311,13 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Atualização incremental (--dynamic): o caso fixo e alterações aleatórias neste grafo
+    if (dynamic_updates > 0) {
+        bool repaired = check_cycle_repair();
+        std::cout << "\nCiclo contraído consertado sem recálculo: " << (repaired ? "sim" : "NÃO") << "\n";
+        bool correct = check_dynamic_updates(graph, root_vertex, dynamic_updates, synthetic_seed);
+        if (!repaired || !correct) return 1;
+    }
+
     return 0;
 }
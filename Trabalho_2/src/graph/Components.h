@@ -0,0 +1,221 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "../util/ThreadPool.h"
+
+// Connected-component labeling (Afforest, Sutton et al. 2018)
+// Lock-free hooking of the larger root under the smaller one, so the root of
+// every component is its smallest vertex and dense ids follow that order
+// (same numbering as a DFS that restarts at the first unvisited vertex)
+
+struct ComponentLabels {
+    std::vector<int> component_of;  // Dense id of each vertex, 0 .. count-1
+    int count = 0;
+
+    // Filled only when colors are given
+    std::vector<int> size;
+    std::vector<long long> r_sum;
+    std::vector<long long> g_sum;
+    std::vector<long long> b_sum;
+};
+
+namespace components_detail {
+
+constexpr int NEIGHBOR_ROUNDS = 2;
+constexpr int SAMPLE_COUNT = 1024;
+
+inline void link(std::vector<std::atomic<int>>& parent, int u, int v) {
+    int p1 = parent[u].load(std::memory_order_relaxed);
+    int p2 = parent[v].load(std::memory_order_relaxed);
+    while (p1 != p2) {
+        int high = std::max(p1, p2);
+        int low = std::min(p1, p2);
+        int p_high = parent[high].load(std::memory_order_relaxed);
+        if (p_high == low) {
+            break;
+        }
+        if (p_high == high && parent[high].compare_exchange_strong(p_high, low)) {
+            break;
+        }
+        p1 = parent[parent[high].load(std::memory_order_relaxed)].load(std::memory_order_relaxed);
+        p2 = parent[low].load(std::memory_order_relaxed);
+    }
+}
+
+inline void compress(std::vector<std::atomic<int>>& parent, int n, ThreadPool& pool) {
+    pool.parallel_for(0, n, [&](int lo, int hi) {
+        for (int v = lo; v < hi; v++) {
+            int p = parent[v].load(std::memory_order_relaxed);
+            int pp = parent[p].load(std::memory_order_relaxed);
+            while (p != pp) {
+                parent[v].store(pp, std::memory_order_relaxed);
+                p = pp;
+                pp = parent[p].load(std::memory_order_relaxed);
+            }
+        }
+    });
+}
+
+// Most frequent root among a random sample of vertices (the giant component)
+inline int sample_frequent_root(const std::vector<std::atomic<int>>& parent, int n) {
+    std::mt19937 rng(27491095u);
+    std::uniform_int_distribution<int> pick(0, n - 1);
+    std::unordered_map<int, int> counts;
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        counts[parent[pick(rng)].load(std::memory_order_relaxed)]++;
+    }
+    auto best = std::max_element(counts.begin(), counts.end(),
+        [](const auto& a, const auto& b) { return a.second < b.second; });
+    return best->first;
+}
+
+}
+
+// Graph needs for_each_neighbor(v, fn) const and is_directed() const
+// Directed graphs are labeled by weak connectivity
+template <typename Graph>
+ComponentLabels label_components(const Graph& graph, int n, ThreadPool& pool = ThreadPool::shared()) {
+    using namespace components_detail;
+
+    ComponentLabels res;
+    if (n <= 0) {
+        return res;
+    }
+
+    std::vector<std::atomic<int>> parent(n);
+    pool.parallel_for(0, n, [&](int lo, int hi) {
+        for (int v = lo; v < hi; v++) {
+            parent[v].store(v, std::memory_order_relaxed);
+        }
+    });
+
+    // Sampling phase: only the first few neighbors of each vertex
+    for (int round = 0; round < NEIGHBOR_ROUNDS; round++) {
+        pool.parallel_for(0, n, [&](int lo, int hi) {
+            for (int u = lo; u < hi; u++) {
+                int idx = 0;
+                graph.for_each_neighbor(u, [&](int v) {
+                    if (idx++ == round) link(parent, u, v);
+                });
+            }
+        });
+        compress(parent, n, pool);
+    }
+
+    // Finish phase: the giant component needs no more work (undirected only,
+    // since its edges are also seen from the other endpoint)
+    int giant = graph.is_directed() ? -1 : sample_frequent_root(parent, n);
+    pool.parallel_for(0, n, [&](int lo, int hi) {
+        for (int u = lo; u < hi; u++) {
+            if (parent[u].load(std::memory_order_relaxed) == giant) continue;
+            int idx = 0;
+            graph.for_each_neighbor(u, [&](int v) {
+                if (idx++ >= NEIGHBOR_ROUNDS) link(parent, u, v);
+            });
+        }
+    });
+    compress(parent, n, pool);
+
+    // Dense ids: count roots per chunk, scan, then number them in vertex order
+    int chunk = std::max(4096, (n + pool.size() * 4 - 1) / (pool.size() * 4));
+    int chunk_count = (n + chunk - 1) / chunk;
+    std::vector<int> chunk_offset(chunk_count + 1, 0);
+    pool.parallel_for(0, chunk_count, [&](int lo, int hi) {
+        for (int c = lo; c < hi; c++) {
+            int end = std::min(n, (c + 1) * chunk);
+            for (int v = c * chunk; v < end; v++) {
+                if (parent[v].load(std::memory_order_relaxed) == v) chunk_offset[c + 1]++;
+            }
+        }
+    }, 1);
+    for (int c = 0; c < chunk_count; c++) {
+        chunk_offset[c + 1] += chunk_offset[c];
+    }
+    res.count = chunk_offset[chunk_count];
+
+    res.component_of.resize(n);
+    pool.parallel_for(0, chunk_count, [&](int lo, int hi) {
+        for (int c = lo; c < hi; c++) {
+            int next_id = chunk_offset[c];
+            int end = std::min(n, (c + 1) * chunk);
+            for (int v = c * chunk; v < end; v++) {
+                if (parent[v].load(std::memory_order_relaxed) == v) res.component_of[v] = next_id++;
+            }
+        }
+    }, 1);
+    // Roots are the smallest vertex of their component, so they were numbered above
+    pool.parallel_for(0, n, [&](int lo, int hi) {
+        for (int v = lo; v < hi; v++) {
+            int root = parent[v].load(std::memory_order_relaxed);
+            if (root != v) res.component_of[v] = res.component_of[root];
+        }
+    });
+
+    return res;
+}
+
+// Same labeling plus per-component size and color sums
+// (colors[v] needs r, g, b: a vector or a VertexProperty of colors)
+template <typename Graph, typename Colors>
+ComponentLabels label_components(
+    const Graph& graph, int n,
+    const Colors& colors,
+    ThreadPool& pool = ThreadPool::shared()
+) {
+    ComponentLabels res = label_components(graph, n, pool);
+    if (n <= 0) {
+        return res;
+    }
+
+    // Color sums: neighbouring pixels mostly share a component, so each chunk
+    // accumulates runs locally and only flushes when the id changes
+    std::vector<std::atomic<int>> size(res.count);
+    std::vector<std::atomic<long long>> r_sum(res.count), g_sum(res.count), b_sum(res.count);
+    pool.parallel_for(0, n, [&](int lo, int hi) {
+        int run_id = res.component_of[lo];
+        int run_size = 0;
+        long long r = 0, g = 0, b = 0;
+        auto flush = [&]() {
+            size[run_id].fetch_add(run_size, std::memory_order_relaxed);
+            r_sum[run_id].fetch_add(r, std::memory_order_relaxed);
+            g_sum[run_id].fetch_add(g, std::memory_order_relaxed);
+            b_sum[run_id].fetch_add(b, std::memory_order_relaxed);
+        };
+        for (int v = lo; v < hi; v++) {
+            int id = res.component_of[v];
+            if (id != run_id) {
+                flush();
+                run_id = id;
+                run_size = 0;
+                r = g = b = 0;
+            }
+            run_size++;
+            r += colors[v].r;
+            g += colors[v].g;
+            b += colors[v].b;
+        }
+        flush();
+    });
+
+    res.size.resize(res.count);
+    res.r_sum.resize(res.count);
+    res.g_sum.resize(res.count);
+    res.b_sum.resize(res.count);
+    pool.parallel_for(0, res.count, [&](int lo, int hi) {
+        for (int c = lo; c < hi; c++) {
+            res.size[c] = size[c].load(std::memory_order_relaxed);
+            res.r_sum[c] = r_sum[c].load(std::memory_order_relaxed);
+            res.g_sum[c] = g_sum[c].load(std::memory_order_relaxed);
+            res.b_sum[c] = b_sum[c].load(std::memory_order_relaxed);
+        }
+    });
+
+    return res;
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef COW_VECTOR_H
+#define COW_VECTOR_H
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Fixed-size vector stored in reference-counted blocks, copied on write
+//
+// Copying a CowVector copies one pointer per block of 1024 values. Both copies
+// then share every block, and a block is only duplicated when one side writes
+// to it (edit()). Graphs keep their adjacency lists here, so a snapshot
+// (copy, clone(), pass by value) costs O(n / 1024) and changing a few vertices
+// of a snapshot copies only their blocks. Blocks nobody has written yet are not
+// allocated at all and read as T().
+//
+// Reads go through the const operator[]; writes must go through edit(). Two
+// threads may edit the same CowVector only in different blocks.
+
+template <typename T>
+class CowVector {
+
+private:
+
+    static constexpr int BLOCK_BITS = 10;
+    static constexpr int BLOCK = 1 << BLOCK_BITS;
+
+    int n;
+    std::vector<std::shared_ptr<std::vector<T>>> blocks;   // nullptr: every value is T()
+
+    static const T& empty() {
+        static const T value{};
+        return value;
+    }
+
+public:
+
+    explicit CowVector(int n = 0)
+    : n(n), blocks((n + BLOCK - 1) / BLOCK) {}
+
+    int size() const {
+        return n;
+    }
+
+    const T& operator[] (int i) const {
+        const auto& block = blocks[i >> BLOCK_BITS];
+        return block ? (*block)[i & (BLOCK - 1)] : empty();
+    }
+
+    // Writable slot i: allocates its block, or copies it if another snapshot shares it
+    T& edit(int i) {
+        auto& block = blocks[i >> BLOCK_BITS];
+        if (!block) {
+            int first = (i >> BLOCK_BITS) << BLOCK_BITS;
+            block = std::make_shared<std::vector<T>>(std::min(BLOCK, n - first));
+        } else if (block.use_count() > 1) {
+            block = std::make_shared<std::vector<T>>(*block);
+        }
+        return (*block)[i & (BLOCK - 1)];
+    }
+
+    // Blocks this vector still shares with some other copy
+    int shared_blocks() const {
+        int count = 0;
+        for (const auto& block : blocks) {
+            count += block && block.use_count() > 1;
+        }
+        return count;
+    }
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef EDGE_LIST_H
+#define EDGE_LIST_H
+
+#include "edge.h"
+#include "../util/RadixSort.h"
+#include "../util/ThreadPool.h"
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+// Edge list as separate arrays (structure of arrays)
+//
+// Kruskal (kruskal_segments) and segment_image order their edges with
+// sorted_order(), and Edmonds' contraction scans every edge keyed by its
+// endpoints and weight. Here each field is its own array, so a pass over the
+// weights touches 4 or 8 bytes per edge instead of a whole Edge, and the sort
+// moves a packed 64-bit key, not the edges.
+//
+// sorted_order() gives the permutation by (weight, position), stable. When every
+// weight fits a float exactly, weight and position share one packed key
+// (float bits << 32 | index) and the sort moves nothing else.
+
+template <typename W = double>
+struct EdgeList {
+    std::vector<uint32_t> u;
+    std::vector<uint32_t> v;
+    std::vector<W> w;
+
+    size_t size() const {
+        return w.size();
+    }
+
+    bool empty() const {
+        return w.empty();
+    }
+
+    void reserve(size_t count) {
+        u.reserve(count);
+        v.reserve(count);
+        w.reserve(count);
+    }
+
+    void resize(size_t count) {
+        u.resize(count);
+        v.resize(count);
+        w.resize(count);
+    }
+
+    void clear() {
+        u.clear();
+        v.clear();
+        w.clear();
+    }
+
+    void push_back(int from, int to, W weight) {
+        u.push_back(from);
+        v.push_back(to);
+        w.push_back(weight);
+    }
+
+    Edge edge(size_t i) const {
+        return Edge(u[i], v[i], w[i]);
+    }
+
+    // Packed keys are possible when no weight loses bits as a float
+    bool packable(ThreadPool& pool = ThreadPool::shared()) const {
+        if constexpr (sizeof(W) <= 2 || std::is_same_v<W, float>) {
+            return size() <= UINT32_MAX;
+        } else {
+            std::atomic<bool> lossy{false};
+            pool.parallel_for(0, static_cast<int>(size()), [&](int lo, int hi) {
+                for (int i = lo; i < hi && !lossy; i++) {
+                    if (static_cast<double>(static_cast<float>(w[i])) != static_cast<double>(w[i])) lossy = true;
+                }
+            });
+            if (lossy) return false;
+            return size() <= UINT32_MAX;
+        }
+    }
+
+    // Positions ordered by (weight, position)
+    std::vector<uint32_t> sorted_order(ThreadPool& pool = ThreadPool::shared()) const {
+        int total = static_cast<int>(size());
+        std::vector<uint32_t> order(total);
+        if (packable(pool)) {
+            std::vector<uint64_t> keys(total);
+            pool.parallel_for(0, total, [&](int lo, int hi) {
+                for (int i = lo; i < hi; i++) {
+                    keys[i] = (static_cast<uint64_t>(radix_sort::sortable_bits(static_cast<float>(w[i]))) << 32) |
+                              static_cast<uint32_t>(i);
+                }
+            });
+            // Keys are built in position order, so only the weight bits need passes
+            radix_sort::sort_keys(keys, pool, 32);
+            pool.parallel_for(0, total, [&](int lo, int hi) {
+                for (int i = lo; i < hi; i++) {
+                    order[i] = static_cast<uint32_t>(keys[i]);
+                }
+            });
+            return order;
+        }
+        std::iota(order.begin(), order.end(), 0u);
+        radix_sort::sort(order, [&](uint32_t i) { return radix_sort::sortable_bits(static_cast<double>(w[i])); }, pool);
+        return order;
+    }
+
+    // Reorders the arrays themselves by (weight, position)
+    void sort_by_weight(ThreadPool& pool = ThreadPool::shared()) {
+        std::vector<uint32_t> order = sorted_order(pool);
+        EdgeList sorted;
+        sorted.resize(size());
+        pool.parallel_for(0, static_cast<int>(size()), [&](int lo, int hi) {
+            for (int i = lo; i < hi; i++) {
+                sorted.u[i] = u[order[i]];
+                sorted.v[i] = v[order[i]];
+                sorted.w[i] = w[order[i]];
+            }
+        });
+        *this = std::move(sorted);
+    }
+
+    // fn(u, v, w) for every edge with keep(u, v, w), in list order
+    template <typename Keep, typename Fn>
+    void for_each(Keep keep, Fn fn) const {
+        for (size_t i = 0; i < size(); i++) {
+            if (keep(static_cast<int>(u[i]), static_cast<int>(v[i]), w[i])) {
+                fn(static_cast<int>(u[i]), static_cast<int>(v[i]), w[i]);
+            }
+        }
+    }
+
+    // Same, in the order of a permutation such as sorted_order()
+    template <typename Keep, typename Fn>
+    void for_each(const std::vector<uint32_t>& order, Keep keep, Fn fn) const {
+        for (uint32_t i : order) {
+            if (keep(static_cast<int>(u[i]), static_cast<int>(v[i]), w[i])) {
+                fn(static_cast<int>(u[i]), static_cast<int>(v[i]), w[i]);
+            }
+        }
+    }
+};
+
+#endif
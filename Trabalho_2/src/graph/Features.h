@@ -0,0 +1,245 @@
+#ifndef FEATURES_H
+#define FEATURES_H
+
+#include "Util.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Per-pixel feature planes for the graph builders
+//
+// Colors and gradient magnitudes are taken out of the [y][x][c] images once, into
+// flat row-major arrays, instead of being recomputed for each of the 4 edges that
+// touch a pixel. CIE Lab planes are optional; they use a 256-entry sRGB -> linear
+// table built at compile time and a cube root approximation, so a row converts
+// without pow/cbrt calls.
+
+namespace features_detail {
+
+// x^(1/5) by Newton's method, for x in [0, 1]
+constexpr double fifth_root(double x) {
+    if (x <= 0.0) return 0.0;
+    double y = 1.0;
+    for (int i = 0; i < 64; i++) {
+        double y4 = y * y * y * y;
+        y = (4.0 * y + x / y4) / 5.0;
+    }
+    return y;
+}
+
+// Same curve as srgb_channel_to_linear; ((c + 0.055) / 1.055)^2.4 = t^2 * (t^(1/5))^2
+constexpr double srgb_to_linear(int value) {
+    double normalized = value / 255.0;
+    if (normalized <= 0.04045) {
+        return normalized / 12.92;
+    }
+    double t = (normalized + 0.055) / 1.055;
+    double root = fifth_root(t);
+    return t * t * root * root;
+}
+
+constexpr std::array<float, 256> make_linear_table() {
+    std::array<float, 256> table{};
+    for (int i = 0; i < 256; i++) {
+        table[i] = static_cast<float>(srgb_to_linear(i));
+    }
+    return table;
+}
+
+constexpr std::array<float, 256> LINEAR = make_linear_table();
+
+// Cube root for x in (0, 2]: exponent-bits estimate plus two Newton steps
+inline float fast_cbrt(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    bits = bits / 3 + 709921077u;
+    float y;
+    std::memcpy(&y, &bits, sizeof(y));
+    y = (2.0f * y + x / (y * y)) * (1.0f / 3.0f);
+    y = (2.0f * y + x / (y * y)) * (1.0f / 3.0f);
+    return y;
+}
+
+// pivot_xyz without the branch
+inline float pivot(float value) {
+    constexpr float epsilon = 0.008856f;
+    constexpr float kappa = 903.3f;
+    float linear = (kappa * value + 16.0f) / 116.0f;
+    return value > epsilon ? fast_cbrt(value) : linear;
+}
+
+}
+
+namespace pixel_metric {
+
+// True for metrics that declare `static constexpr bool uses_lab = true` (see PixelMetric.h)
+template <typename Metric, typename = void>
+struct reads_lab : std::false_type {};
+
+template <typename Metric>
+struct reads_lab<Metric, std::void_t<decltype(Metric::uses_lab)>> : std::bool_constant<Metric::uses_lab> {};
+
+template <typename Metric>
+constexpr bool uses_lab = reads_lab<Metric>::value;
+
+}
+
+// Everything a pixel metric can look at, by value
+struct PixelFeature {
+    int r;
+    int g;
+    int b;
+    double gradient;
+    float L;
+    float A;
+    float B;
+};
+
+struct FeaturePlanes {
+    int width = 0;
+    int height = 0;
+
+    // Color of each pixel (index x + y * width)
+    std::vector<int> r;
+    std::vector<int> g;
+    std::vector<int> b;
+
+    // gradient_magnitude of each Sobel pixel, in [0, 1]
+    std::vector<double> gradient;
+
+    // CIE Lab (D65), filled only when asked for
+    std::vector<float> L;
+    std::vector<float> A;
+    std::vector<float> B;
+
+    int size() const {
+        return width * height;
+    }
+
+    bool has_lab() const {
+        return !L.empty();
+    }
+
+    static FeaturePlanes from_images(
+        const std::vector<std::vector<std::vector<int>>> &color_img,
+        const std::vector<std::vector<std::vector<int>>> &gradient_img,
+        int width, int height,
+        bool with_lab = false
+    ) {
+        FeaturePlanes planes;
+        planes.assign(color_img, gradient_img, width, height, with_lab);
+        return planes;
+    }
+
+    // Colors only, gradient 0 everywhere (from_ppm_matrix)
+    static FeaturePlanes from_image(
+        const std::vector<std::vector<std::vector<int>>> &color_img,
+        int width, int height,
+        bool with_lab = false
+    ) {
+        FeaturePlanes planes;
+        planes.width = width;
+        planes.height = height;
+        int n = width * height;
+        planes.r.resize(n);
+        planes.g.resize(n);
+        planes.b.resize(n);
+        planes.gradient.assign(n, 0.0);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int i = x + y * width;
+                planes.r[i] = color_img[y][x][0];
+                planes.g[i] = color_img[y][x][1];
+                planes.b[i] = color_img[y][x][2];
+            }
+        }
+        if (with_lab) {
+            planes.compute_lab();
+        }
+        return planes;
+    }
+
+    // Refills the planes, reusing their storage
+    void assign(
+        const std::vector<std::vector<std::vector<int>>> &color_img,
+        const std::vector<std::vector<std::vector<int>>> &gradient_img,
+        int width, int height,
+        bool with_lab = false
+    ) {
+        this->width = width;
+        this->height = height;
+        int n = width * height;
+        r.resize(n);
+        g.resize(n);
+        b.resize(n);
+        gradient.resize(n);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int i = x + y * width;
+                r[i] = color_img[y][x][0];
+                g[i] = color_img[y][x][1];
+                b[i] = color_img[y][x][2];
+                gradient[i] = gradient_magnitude(gradient_img[y][x]);
+            }
+        }
+        if (with_lab) {
+            compute_lab();
+        }
+        else {
+            L.clear();
+            A.clear();
+            B.clear();
+        }
+    }
+
+    // Lab from the color planes, one row at a time
+    void compute_lab() {
+        using namespace features_detail;
+        int n = size();
+        L.resize(n);
+        A.resize(n);
+        B.resize(n);
+        std::vector<float> lr(width), lg(width), lb(width);
+        for (int y = 0; y < height; y++) {
+            int row = y * width;
+            // Table lookups first, so the arithmetic below is a plain loop over floats
+            for (int x = 0; x < width; x++) {
+                lr[x] = LINEAR[r[row + x] & 255];
+                lg[x] = LINEAR[g[row + x] & 255];
+                lb[x] = LINEAR[b[row + x] & 255];
+            }
+            // rgb_to_xyz / 100 and the reference white of rgb_to_lab_color folded together
+            for (int x = 0; x < width; x++) {
+                float fx = pivot((lr[x] * 0.4124564f + lg[x] * 0.3575761f + lb[x] * 0.1804375f) * (100.0f / 95.047f));
+                float fy = pivot(lr[x] * 0.2126729f + lg[x] * 0.7151522f + lb[x] * 0.0721750f);
+                float fz = pivot((lr[x] * 0.0193339f + lg[x] * 0.1191920f + lb[x] * 0.9503041f) * (100.0f / 108.883f));
+                L[row + x] = std::max(0.0f, 116.0f * fy - 16.0f);
+                A[row + x] = 500.0f * (fx - fy);
+                B[row + x] = 200.0f * (fy - fz);
+            }
+        }
+    }
+
+    // Features of pixel i; Lab is read only when asked for (and then needs has_lab())
+    template <bool WithLab = false>
+    PixelFeature pixel(int i) const {
+        PixelFeature res{r[i], g[i], b[i], gradient[i], 0.0f, 0.0f, 0.0f};
+        if constexpr (WithLab) {
+            res.L = L[i];
+            res.A = A[i];
+            res.B = B[i];
+        }
+        return res;
+    }
+
+    // metric(pixel(p), pixel(q)); see PixelMetric.h
+    template <typename Metric>
+    double weight(int p, int q, const Metric &metric) const {
+        constexpr bool with_lab = pixel_metric::uses_lab<Metric>;
+        return metric(pixel<with_lab>(p), pixel<with_lab>(q));
+    }
+};
+
+#endif
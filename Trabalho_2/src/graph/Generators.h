@@ -0,0 +1,333 @@
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include "GraphFile.h"
+#include "../util/RadixSort.h"
+#include "../util/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+// Seeded synthetic directed graphs for benchmarks
+//
+// Edges are generated in fixed blocks of BLOCK edges. Each block has its own RNG
+// stream, derived from (seed, family, block index), and blocks run in parallel on
+// the thread pool. So the same seed gives the same graph on any number of threads.
+// Edges go straight into flat source/target/weight arrays. build_csr() then turns
+// them into a graph_file::Csr, with a parallel radix sort by (source, target) and
+// self-loops and duplicate pairs dropped (the lightest copy stays). Nothing goes through DirectedGraph's hash maps until the caller asks
+// for it.
+
+namespace generators {
+
+constexpr int64_t BLOCK = 1 << 16;
+
+// xoshiro256** seeded through splitmix64
+class Rng {
+
+private:
+
+    uint64_t s[4];
+
+    static uint64_t splitmix(uint64_t& x) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+
+    Rng(uint64_t seed, uint64_t stream) {
+        uint64_t x = seed ^ (stream * 0xd1b54a32d192ed03ull);
+        for (uint64_t& word : s) word = splitmix(x);
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, 1)
+    double uniform() {
+        return (next() >> 11) * 0x1.0p-53;
+    }
+
+    // Uniform in [0, bound)
+    uint64_t below(uint64_t bound) {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+    }
+};
+
+struct WeightRange {
+    double low = 0.1;
+    double high = 10.0;
+
+    double operator()(Rng& rng) const {
+        return low + (high - low) * rng.uniform();
+    }
+};
+
+// Flat edge arrays, filled block by block
+struct EdgeArrays {
+    int vertices = 0;
+    std::vector<uint32_t> source;
+    std::vector<uint32_t> target;
+    std::vector<double> weight;
+
+    void resize(int64_t edges) {
+        source.resize(edges);
+        target.resize(edges);
+        weight.resize(edges);
+    }
+
+    int64_t size() const {
+        return source.size();
+    }
+};
+
+enum Family : uint64_t {
+    ERDOS_RENYI = 1,
+    RMAT = 2,
+    POWER_LAW = 3,
+    GRID = 4,
+    ARBORESCENCE = 5
+};
+
+// fn(rng, first, last) for every block of [0, edges), each block with its own stream
+template <typename Fn>
+void for_each_block(int64_t edges, uint64_t seed, Family family, Fn fn, ThreadPool& pool) {
+    int blocks = static_cast<int>((edges + BLOCK - 1) / BLOCK);
+    pool.parallel_for(0, blocks, [&](int lo, int hi) {
+        for (int b = lo; b < hi; b++) {
+            Rng rng(seed, (static_cast<uint64_t>(family) << 40) + b);
+            fn(rng, b * BLOCK, std::min(edges, (b + 1) * BLOCK));
+        }
+    }, 1);
+}
+
+// Directed CSR of the edge arrays: rows sorted by target, self-loops and duplicates removed
+// A radix sort on (source, target) instead of scattering by source: the passes read
+// and write almost sequentially, while a direct scatter misses the cache on every edge
+inline graph_file::Csr build_csr(const EdgeArrays& edges, ThreadPool& pool = ThreadPool::shared()) {
+    struct Entry {
+        uint32_t source;
+        uint32_t target;
+        double weight;
+    };
+    int n = edges.vertices;
+    int64_t edge_total = edges.size();
+    if (edge_total > static_cast<int64_t>(INT32_MAX)) {
+        throw std::length_error("Too many edges for one generator run");
+    }
+    int m = static_cast<int>(edge_total);
+
+    std::vector<Entry> entries(m);
+    pool.parallel_for(0, m, [&](int lo, int hi) {
+        for (int e = lo; e < hi; e++) {
+            entries[e] = Entry{edges.source[e], edges.target[e], edges.weight[e]};
+        }
+    });
+    auto key = [](const Entry& e) { return (static_cast<uint64_t>(e.source) << 32) | e.target; };
+    radix_sort::sort(entries, key, pool);
+
+    // First entry of each (source, target) run, without self-loops; it takes the run's lightest weight
+    auto starts_run = [&](int i) {
+        return entries[i].source != entries[i].target && (i == 0 || key(entries[i]) != key(entries[i - 1]));
+    };
+    int chunk = std::max(1 << 16, (m + pool.size() * 4 - 1) / std::max(1, pool.size() * 4));
+    int chunk_count = (m + chunk - 1) / chunk;
+    std::vector<int> kept(chunk_count + 1, 0);
+    pool.parallel_for(0, chunk_count, [&](int lo, int hi) {
+        for (int c = lo; c < hi; c++) {
+            int count = 0;
+            for (int i = c * chunk; i < std::min(m, (c + 1) * chunk); i++) count += starts_run(i);
+            kept[c + 1] = count;
+        }
+    }, 1);
+    for (int c = 0; c < chunk_count; c++) {
+        kept[c + 1] += kept[c];
+    }
+
+    graph_file::Csr csr;
+    csr.directed = true;
+    csr.offsets.assign(n + 1, 0);
+    csr.targets.resize(kept[chunk_count]);
+    csr.weights.resize(kept[chunk_count]);
+    std::vector<uint32_t> row_of(kept[chunk_count]);
+    pool.parallel_for(0, chunk_count, [&](int lo, int hi) {
+        for (int c = lo; c < hi; c++) {
+            int out = kept[c];
+            for (int i = c * chunk; i < std::min(m, (c + 1) * chunk); i++) {
+                if (!starts_run(i)) continue;
+                double lightest = entries[i].weight;
+                for (int j = i + 1; j < m && key(entries[j]) == key(entries[i]); j++) {
+                    lightest = std::min(lightest, entries[j].weight);
+                }
+                row_of[out] = entries[i].source;
+                csr.targets[out] = entries[i].target;
+                csr.weights[out] = lightest;
+                out++;
+            }
+        }
+    }, 1);
+
+    // offsets[u] = first entry of a row >= u; each position fills the gap after the previous row
+    int total = kept[chunk_count];
+    pool.parallel_for(0, total, [&](int lo, int hi) {
+        for (int j = lo; j < hi; j++) {
+            int previous = j == 0 ? -1 : static_cast<int>(row_of[j - 1]);
+            for (int u = previous + 1; u <= static_cast<int>(row_of[j]); u++) csr.offsets[u] = j;
+        }
+    });
+    for (int u = total == 0 ? 0 : row_of[total - 1] + 1; u <= n; u++) {
+        csr.offsets[u] = total;
+    }
+    return csr;
+}
+
+// G(n, m): m uniformly random ordered pairs
+inline EdgeArrays erdos_renyi(int vertices, int64_t edges, uint64_t seed, WeightRange weights = {},
+                              ThreadPool& pool = ThreadPool::shared()) {
+    EdgeArrays res;
+    res.vertices = vertices;
+    res.resize(edges);
+    for_each_block(edges, seed, ERDOS_RENYI, [&](Rng& rng, int64_t first, int64_t last) {
+        for (int64_t e = first; e < last; e++) {
+            res.source[e] = rng.below(vertices);
+            res.target[e] = rng.below(vertices);
+            res.weight[e] = weights(rng);
+        }
+    }, pool);
+    return res;
+}
+
+// R-MAT (Kronecker) with 2^scale vertices: each edge descends scale levels into
+// quadrant a / b / c / d of the adjacency matrix (Graph500 defaults)
+inline EdgeArrays rmat(int scale, int64_t edges, uint64_t seed, WeightRange weights = {},
+                       double a = 0.57, double b = 0.19, double c = 0.19,
+                       ThreadPool& pool = ThreadPool::shared()) {
+    if (scale < 1 || scale > 30) {
+        throw std::invalid_argument("R-MAT scale must be in [1, 30]");
+    }
+    EdgeArrays res;
+    res.vertices = 1 << scale;
+    res.resize(edges);
+    for_each_block(edges, seed, RMAT, [&](Rng& rng, int64_t first, int64_t last) {
+        for (int64_t e = first; e < last; e++) {
+            uint32_t u = 0, v = 0;
+            for (int level = 0; level < scale; level++) {
+                double r = rng.uniform();
+                uint32_t down = r >= a + b;                         // c or d
+                uint32_t right = (r >= a && r < a + b) || r >= a + b + c;  // b or d
+                u = (u << 1) | down;
+                v = (v << 1) | right;
+            }
+            res.source[e] = u;
+            res.target[e] = v;
+            res.weight[e] = weights(rng);
+        }
+    }, pool);
+    return res;
+}
+
+// Chung-Lu: vertex i has expected degree proportional to (i + 1)^(-1 / (exponent - 1)),
+// so degrees follow a power law with that exponent; endpoints by binary search on the CDF
+inline EdgeArrays power_law(int vertices, int64_t edges, double exponent, uint64_t seed, WeightRange weights = {},
+                            ThreadPool& pool = ThreadPool::shared()) {
+    if (exponent <= 1.0) {
+        throw std::invalid_argument("Power-law exponent must be > 1");
+    }
+    std::vector<double> cdf(vertices);
+    double total = 0.0;
+    for (int i = 0; i < vertices; i++) {
+        total += std::pow(i + 1.0, -1.0 / (exponent - 1.0));
+        cdf[i] = total;
+    }
+    auto pick = [&](Rng& rng) {
+        double r = rng.uniform() * total;
+        int i = std::upper_bound(cdf.begin(), cdf.end(), r) - cdf.begin();
+        return static_cast<uint32_t>(std::min(i, vertices - 1));
+    };
+
+    EdgeArrays res;
+    res.vertices = vertices;
+    res.resize(edges);
+    for_each_block(edges, seed, POWER_LAW, [&](Rng& rng, int64_t first, int64_t last) {
+        for (int64_t e = first; e < last; e++) {
+            res.source[e] = pick(rng);
+            res.target[e] = pick(rng);
+            res.weight[e] = weights(rng);
+        }
+    }, pool);
+    return res;
+}
+
+// width x height grid, both directions of every 4-neighbour (8 with diagonals) pair
+inline EdgeArrays grid(int width, int height, bool diagonals, uint64_t seed, WeightRange weights = {},
+                       ThreadPool& pool = ThreadPool::shared()) {
+    static const int DX[8] = {1, 0, -1, 0, 1, -1, 1, -1};
+    static const int DY[8] = {0, 1, 0, -1, 1, 1, -1, -1};
+    int directions = diagonals ? 8 : 4;
+    int64_t n = static_cast<int64_t>(width) * height;
+
+    EdgeArrays res;
+    res.vertices = static_cast<int>(n);
+    // One slot per (pixel, direction); slots that leave the grid become self-loops and are dropped
+    res.resize(n * directions);
+    for_each_block(n * directions, seed, GRID, [&](Rng& rng, int64_t first, int64_t last) {
+        for (int64_t e = first; e < last; e++) {
+            int64_t p = e / directions;
+            int d = e % directions;
+            int x = p % width + DX[d], y = p / width + DY[d];
+            bool inside = x >= 0 && x < width && y >= 0 && y < height;
+            res.source[e] = p;
+            res.target[e] = inside ? y * width + x : p;
+            res.weight[e] = weights(rng);
+        }
+    }, pool);
+    return res;
+}
+
+// Random recursive tree from root 0 (parent of v uniform in [0, v)) plus
+// extra_edges uniform random edges: always has a spanning arborescence from 0
+inline EdgeArrays arborescence(int vertices, int64_t extra_edges, uint64_t seed, WeightRange weights = {},
+                               ThreadPool& pool = ThreadPool::shared()) {
+    int64_t tree_edges = std::max(0, vertices - 1);
+    EdgeArrays res;
+    res.vertices = vertices;
+    res.resize(tree_edges + extra_edges);
+    for_each_block(tree_edges + extra_edges, seed, ARBORESCENCE, [&](Rng& rng, int64_t first, int64_t last) {
+        for (int64_t e = first; e < last; e++) {
+            if (e < tree_edges) {
+                uint32_t v = e + 1;
+                res.source[e] = rng.below(v);
+                res.target[e] = v;
+            }
+            else {
+                res.source[e] = rng.below(vertices);
+                res.target[e] = rng.below(vertices);
+            }
+            res.weight[e] = weights(rng);
+        }
+    }, pool);
+    return res;
+}
+
+}
+
+#endif
@@ -11,9 +11,16 @@
 #include <algorithm>
 #include <unordered_set>
 #include <unordered_map>
+#include <type_traits>
 #include <stdio.h>
 #include <stdlib.h>
 #include "Util.h"
+#include "PixelMetric.h"
+#include "Weights.h"
+#include "Components.h"
+#include "GraphFile.h"
+#include "CowVector.h"
+#include "VertexProperties.h"
 
 class Graph{
 
@@ -22,8 +29,8 @@ private:
     int n; // maximum capacity
     int last_vert; //current size
     bool directed;
-    std::vector<std::unordered_set<int>> arr; //adjacency list
-    std::vector<std::string> label;
+    CowVector<std::unordered_set<int>> arr; //adjacency list (shared between copies until written)
+    VertexLabels label; // Allocated on the first label
 
 public:
 
@@ -38,13 +45,9 @@ public:
 		return last_vert;
 	}
 
+	// Snapshot: shares the adjacency blocks, each side copies a block when it writes to it
 	Graph* clone(void) {
-		Graph* sub = new Graph(this->n);
-		sub->last_vert = this->last_vert;
-		sub->directed = this->directed;
-		sub->arr = this->arr;
-		sub->label = this->label;
-		return (sub);
+		return new Graph(*this);
 	}
 
     bool add_vert(){
@@ -57,7 +60,7 @@ public:
 
     bool add_vert(std::string label){
         if(last_vert < n){
-            this->label[last_vert] = label;
+            this->label.set(last_vert, label);
             last_vert++;
             return true;
         }
@@ -67,7 +70,7 @@ public:
     void setLabel(int vert, std::string label)
     {
         if (vert <= last_vert) {
-            this->label[vert] = label;
+            this->label.set(vert, label);
         } 
         else {
             throw std::invalid_argument("Vertex does not exist");
@@ -77,13 +80,18 @@ public:
     std::string getLabel(int vert)
     {
         if (vert <= last_vert) {
-            return (this->label[vert]);
+            return (this->label.get(vert));
         }
         else {
             throw std::invalid_argument("Vertex does not exist");
         }
     }
 
+    // First vertex with this label, or -1
+    int find_vert(const std::string& label) const {
+        return this->label.find(label);
+    }
+
     void all_verts(){
         while(add_vert()); // Adicionar todos os vertices possiveis
     }
@@ -100,9 +108,9 @@ public:
     bool add_edge(int vert1, int vert2){
         if(vert1 <= last_vert && vert2 <= last_vert){
             if(arr[vert1].count(vert2) == 0){ // Verifica se a aresta ja existe
-                arr[vert1].insert(vert2);
+                arr.edit(vert1).insert(vert2);
                 if (!directed) {
-                    arr[vert2].insert(vert1);
+                    arr.edit(vert2).insert(vert1);
                 }
                 return true; // Aresta adicionada
             }
@@ -125,9 +133,9 @@ public:
 
     bool remove_edge(int vert1, int vert2){
         if(check_edge(vert1, vert2)){
-            arr[vert1].erase(vert2);
+            arr.edit(vert1).erase(vert2);
             if (!directed) {
-                arr[vert2].erase(vert1);
+                arr.edit(vert2).erase(vert1);
             }
             return true;
         }
@@ -157,11 +165,11 @@ public:
 
     void print_raw(){
         for(int i=0; i<last_vert; i++) {
-            if (label[last_vert] != "") {
+            if (label.empty(i)) {
                 std::cout << i << " ) ";
             }
             else {
-                std::cout << i << " : \"" << label[i] << "\" ) ";
+                std::cout << i << " : \"" << label.get(i) << "\" ) ";
             }
             printVec(arr[i]);
         }
@@ -207,112 +215,69 @@ public:
 };
 
 
-class WeightedGraph{
+// W: weight type (double, float, Fixed16)
+// Multiplicity: SingleWeight (one weight per pair) or InlineWeights (parallel edges)
+template <typename W, template <typename> class Multiplicity>
+class BasicWeightedGraph{
+
+public:
+
+    using weight_type = W;
+    using WeightSlot = Multiplicity<W>;
 
 private:
 
     int n; // maximum capacity
     int last_vert; //current size
     bool directed; 
-    std::vector<std::unordered_map<int, std::vector<double>>> arr; //adjacency list
-    std::vector<std::string> label;
-    std::vector<RGB> pix_color;
+    CowVector<std::unordered_map<int, WeightSlot>> arr; //adjacency list (shared between copies until written)
+    VertexLabels label; // Allocated on the first label
+    VertexProperty<RGB> pix_color; // Allocated on the first color
 
 public:
 
     //Constructor
-    WeightedGraph(int n, bool directed = false)
+    BasicWeightedGraph(int n, bool directed = false)
     : n(n), last_vert(0), directed(directed), arr(n), label(n), pix_color(n) {}
 
     //Destructor
-    ~WeightedGraph() = default;
+    ~BasicWeightedGraph() = default;
 
 	void setPixColor(std::vector<RGB> pc) {
-		this->pix_color = pc;
+		this->pix_color.assign(pc);
+	}
+
+	std::vector<RGB> getPixColor() const {
+		return this->pix_color.to_vector();
 	}
 
-	std::vector<RGB> getPixColor() {
-		return this->pix_color;
+	bool hasPixColor() const {
+		return this->pix_color.allocated();
 	}
 
-    static WeightedGraph from_ppm_matrix(
+    // 8-neighbour grid, weight rgb_diff + wscaling * rgb_max
+    static BasicWeightedGraph from_ppm_matrix(
         std::vector<std::vector<std::vector<int>>> &img,
         int width, int height,
 		double wscaling = 0.0,
         bool directed = false
     ) {
-        int nVerts = width * height;
-        WeightedGraph res (nVerts, directed);
-
-        // printf("width = %d\nheight = %d\nnVerts = %d\nres size = %d\n", width, height, nVerts, res.n);
-
-        res.all_verts();
-
-        for(int i=0; i<nVerts; i++){
-            int x = i % width,
-            y = i / width;
-
-            bool leftEdge = x < 1,
-                rightEdge = x == width-1, 
-                underEdge = y == height-1;
-
-            res.pix_color[i].r = img[y][x][0];
-            res.pix_color[i].g = img[y][x][1];
-            res.pix_color[i].b = img[y][x][2];
-
-            // printf("i = %d\nx = %d\ny = %d\n", i, x, y);
-            // printf("leftEdge = %d, rightEdge = %d, underEdge = %d\n", leftEdge, rightEdge, underEdge);
-
-            if (!leftEdge && !underEdge) { // Diagonal esq-baixo
-                int other = (x-1) + ( (y+1) * width );
-                // std::cout << "(diag esq baixo) i = " << i << " | other = " << other << std::endl;
-				//
-                double diff = rgb_diff(img[y][x], img[y+1][x-1]);
-				double G = rgb_max(img[y][x], img[y+1][x-1]);
-				double w = G * wscaling;
-
-                res.add_edge(i, other, diff+w);
-            }
-
-            if (!underEdge) { // Para baixo
-                int other = (x) + ( (y+1) * width );
-                // std::cout << "(baixo) i = " << i << " | other = " << other << std::endl;
-
-                double diff = rgb_diff(img[y][x], img[y+1][x]);
-				double G = rgb_max(img[y][x], img[y+1][x]);
-				double w = (G * wscaling);
-
-                res.add_edge(i, other, diff+w);
-            }
-
-            if (!underEdge && !rightEdge) { // Diagonal baixo-direita
-                int other = (x+1) + ( (y+1) * width );
-                // std::cout << "(diag baix esq) i = " << i << " | other = " << other << std::endl;
-
-                double diff = rgb_diff(img[y][x], img[y+1][x+1]);
-				double G = rgb_max(img[y][x], img[y+1][x+1]);
-				double w = (G * wscaling);
-
-                res.add_edge(i, other, diff+w);
-            }
-
-            if (!rightEdge) { // Para direita
-                int other = (x+1) + ( (y) * width );
-                // std::cout << "(direita) i = " << i << " | other = " << other << std::endl;
-
-                double diff = rgb_diff(img[y][x], img[y][x+1]);
-				double G = rgb_max(img[y][x], img[y][x+1]);
-				double w = (G * wscaling);
-
-                res.add_edge(i, other, diff+w);
-            }
-
-        }
+        return from_ppm_matrix(img, width, height, pixel_metric::BrightnessBlended<>{wscaling}, directed);
+    }
 
-        return res;
+    // Same grid with any pixel metric over the image colors (gradient reads as 0)
+    template <typename Metric, typename = std::enable_if_t<!std::is_arithmetic_v<Metric>>>
+    static BasicWeightedGraph from_ppm_matrix(
+        const std::vector<std::vector<std::vector<int>>> &img,
+        int width, int height,
+        const Metric &metric,
+        bool directed = false
+    ) {
+        FeaturePlanes planes = FeaturePlanes::from_image(img, width, height, pixel_metric::uses_lab<Metric>);
+        return from_feature_planes(planes, metric, directed);
     }
 
-    static WeightedGraph from_color_and_gradient(
+    static BasicWeightedGraph from_color_and_gradient(
         const std::vector<std::vector<std::vector<int>>> &color_img,
         const std::vector<std::vector<std::vector<int>>> &gradient_img,
         int width,
@@ -321,24 +286,25 @@ public:
         double gradient_scale,
         bool directed = false
     ) {
-        int nVerts = width * height;
-        WeightedGraph res(nVerts, directed);
-        res.all_verts();
+        FeaturePlanes planes = FeaturePlanes::from_images(color_img, gradient_img, width, height);
+        return from_feature_planes(planes, pixel_metric::GradientBlended<>{color_scale, gradient_scale}, directed);
+    }
 
-        auto compute_gradient = [](const std::vector<int> &pixel) -> double {
-            if (pixel.empty()) {
-                return 0.0;
-            }
-            double sum_sq = 0.0;
-            for (int channel_value : pixel) {
-                sum_sq += static_cast<double>(channel_value) * static_cast<double>(channel_value);
-            }
-            double denominator = std::sqrt(static_cast<double>(std::max<size_t>(1, pixel.size()))) * 255.0;
-            if (denominator == 0.0) {
-                return 0.0;
-            }
-            return std::sqrt(sum_sq) / denominator;
-        };
+    // Grid graph (4 forward neighbours per pixel) weighted by a pixel metric (see PixelMetric.h)
+    template <typename Metric>
+    static BasicWeightedGraph from_feature_planes(
+        const FeaturePlanes &planes,
+        const Metric &metric,
+        bool directed = false
+    ) {
+        if (pixel_metric::uses_lab<Metric> && !planes.has_lab()) {
+            throw std::invalid_argument("Metric needs Lab planes");
+        }
+        int width = planes.width;
+        int height = planes.height;
+        int nVerts = planes.size();
+        BasicWeightedGraph res(nVerts, directed);
+        res.all_verts();
 
         for (int i = 0; i < nVerts; i++) {
             int x = i % width;
@@ -348,31 +314,23 @@ public:
             bool rightEdge = x == width - 1;
             bool underEdge = y == height - 1;
 
-            res.pix_color[i].r = color_img[y][x][0];
-            res.pix_color[i].g = color_img[y][x][1];
-            res.pix_color[i].b = color_img[y][x][2];
-
-            auto accumulate_edge = [&](int other_x, int other_y) {
-                int other = other_x + other_y * width;
-                double color_diff = rgb_diff(color_img[y][x], color_img[other_y][other_x]);
-                double grad_current = compute_gradient(gradient_img[y][x]);
-                double grad_other = compute_gradient(gradient_img[other_y][other_x]);
-                double grad_weight = (grad_current + grad_other) * 0.5 * 100.0;
-                double weight = color_scale * color_diff + gradient_scale * grad_weight;
-                res.add_edge(i, other, weight);
+            res.pix_color.set(i, RGB(planes.r[i], planes.g[i], planes.b[i]));
+
+            auto accumulate_edge = [&](int other) {
+                res.add_edge(i, other, planes.weight(i, other, metric));
             };
 
             if (!leftEdge && !underEdge) {
-                accumulate_edge(x - 1, y + 1);
+                accumulate_edge(i + width - 1);
             }
             if (!underEdge) {
-                accumulate_edge(x, y + 1);
+                accumulate_edge(i + width);
             }
             if (!underEdge && !rightEdge) {
-                accumulate_edge(x + 1, y + 1);
+                accumulate_edge(i + width + 1);
             }
             if (!rightEdge) {
-                accumulate_edge(x + 1, y);
+                accumulate_edge(i + 1);
             }
         }
 
@@ -394,123 +352,122 @@ public:
                 underEdge = y == height-1;
             */
 
-            res[y][x][0] = this->pix_color[i].r;
-            res[y][x][1] = this->pix_color[i].g;
-            res[y][x][2] = this->pix_color[i].b;
+            const RGB& color = this->pix_color[i];
+            res[y][x][0] = color.r;
+            res[y][x][1] = color.g;
+            res[y][x][2] = color.b;
         }
 
         return res;
     }
 
-    void paint_components(std::vector<RGB> colors) {
-        // std::unordered_set<int> visited = std::unordered_set<int>(this->last_vert);
-        std::vector<bool> visited = std::vector<bool>(this->last_vert, false);
-        int nVisited = 0;
-        std::vector<int> stack;
-        stack.push_back(0);
-        int crrComp = 0;
-        while (nVisited < this->last_vert) {
-            if (stack.empty()){ // Empty stack (jump component)
-                // std::cout << "\nstack empty\n";
-                int i;
-                for(i=0; i<this->last_vert && visited[i]; i++);
-                stack.push_back(i);
-                crrComp++;
-            }
-            // else {std::cout << "stack: "; for(int j=0; j<stack.size(); std::cout << stack[j++] << " "); std::cout << "\n";}
-            int crr = stack.back();
-            stack.pop_back();
-            if (!visited[crr]){
-                // visited.insert(crr);
-                visited[crr] = true;
-                nVisited++;
-                this->pix_color[crr].r = colors[crrComp].r;
-                this->pix_color[crr].g = colors[crrComp].g;
-                this->pix_color[crr].b = colors[crrComp].b;
-                // std::cout << crr << " | ";
-                std::unordered_map<int, std::vector<double>> sons = this->vert_neighbors(crr);
-                for (auto [son, weight]: sons) {
-                    stack.push_back(son);
-                }
-            }
-        }
-        // std::cout << "\n\n";
-    }
-
-    std::vector<RGB> get_colors_components() {
-        //std::unordered_set<int> visited = std::unordered_set<int>(this->last_vert);
-        std::vector<bool> visited = std::vector<bool>(this->last_vert, false);
-        int nVisited = 0;
-        std::vector<int> stack;
-        std::vector<RGB> colors;
-        stack.push_back(0);
-        int crrComp = 0;
-        int nPixelsComp = 0;
-        long r_sum = 0, g_sum = 0, b_sum = 0;
-        while (nVisited < this->last_vert) {
-            if (stack.empty()){ // Empty stack (jump component)
-                // std::cout << "\nstack empty\n";
-                int i;
-                for(i=0; i<this->last_vert && visited[i]; i++);
-                stack.push_back(i);
-                r_sum /= nPixelsComp;
-                g_sum /= nPixelsComp;
-                b_sum /= nPixelsComp;
-                colors.push_back(RGB(r_sum, g_sum, b_sum));
-                nPixelsComp = 0;
-                crrComp++;
-                r_sum = g_sum = b_sum = 0;
-            }
-            // else {std::cout << "stack: "; for(int j=0; j<stack.size(); std::cout << stack[j++] << " "); std::cout << "\n";}
-            int crr = stack.back();
-            stack.pop_back();
-            if (!visited[crr]){
-                visited[crr] = true;
-                nVisited++;
-                r_sum += this->pix_color[crr].r;
-                g_sum += this->pix_color[crr].g;
-                b_sum += this->pix_color[crr].b;
-                nPixelsComp++;
-                // std::cout << crr << " | ";
-                std::unordered_map<int, std::vector<double>> sons = this->vert_neighbors(crr);
-                for (auto [son, weight]: sons) {
-                    stack.push_back(son);
-                }
+    // Dense component id of every vertex (parallel, see Components.h)
+    ComponentLabels label_components() const {
+        return ::label_components(*this, this->last_vert, this->pix_color);
+    }
+
+    // Paints component c with colors[c]; components are numbered by their smallest vertex
+    void paint_components(const std::vector<RGB>& colors) {
+        ComponentLabels labels = ::label_components(*this, this->last_vert);
+        this->paint_components(labels, colors);
+    }
+
+    void paint_components(const ComponentLabels& labels, const std::vector<RGB>& colors) {
+        RGB* painted = this->pix_color.data();
+        ThreadPool::shared().parallel_for(0, this->last_vert, [&](int lo, int hi) {
+            for (int v = lo; v < hi; v++) {
+                painted[v] = colors[labels.component_of[v]];
             }
+        });
+    }
+
+    std::vector<RGB> get_colors_components() const {
+        return average_colors(this->label_components());
+    }
+
+    static std::vector<RGB> average_colors(const ComponentLabels& labels) {
+        std::vector<RGB> colors(labels.count);
+        for (int c = 0; c < labels.count; c++) {
+            colors[c] = RGB(labels.r_sum[c] / labels.size[c],
+                            labels.g_sum[c] / labels.size[c],
+                            labels.b_sum[c] / labels.size[c]);
         }
-        r_sum /= nPixelsComp;
-        g_sum /= nPixelsComp;
-        b_sum /= nPixelsComp;
-        colors.push_back(RGB(r_sum, g_sum, b_sum));
-        // std::cout << "\n\n";
         return colors;
     }
 
     void avg_colors_components() {
         clock_t start = clock();
-        std::vector<RGB> colors = this->get_colors_components();
+        ComponentLabels labels = this->label_components();
+        std::vector<RGB> colors = average_colors(labels);
         clock_t getColors = clock();
-        /*
-        for(int i=0; i<colors.size(); i++){
-            printf("[0x%02x%02x%02x]", colors[i].r, colors[i].g, colors[i].b);
-        }
-        */
-        this->paint_components(colors);
+        this->paint_components(labels, colors);
         clock_t end = clock();
-        printf("\nAVG COLORS:\nGet Colosrs: %lf\nPainting: %lf\n\n", (((double)(getColors-start))/CLOCKS_PER_SEC), (((double)(end-getColors))/CLOCKS_PER_SEC));
+        printf("\nAVG COLORS:\nGet Colors: %lf\nPainting: %lf\n\n", (((double)(getColors-start))/CLOCKS_PER_SEC), (((double)(end-getColors))/CLOCKS_PER_SEC));
+    }
+
+    // Binary CSR file (see GraphFile.h); every weight of a pair is its own entry
+    bool save_binary(const std::string& path) const {
+        graph_file::Csr csr;
+        csr.directed = this->directed;
+        csr.offsets.reserve(this->last_vert + 1);
+        csr.offsets.push_back(0);
+        std::vector<int> neighbors;
+        for (int u = 0; u < this->last_vert; u++) {
+            neighbors.clear();
+            for (const auto& entry : arr[u]) neighbors.push_back(entry.first);
+            std::sort(neighbors.begin(), neighbors.end());
+            for (int v : neighbors) {
+                for (W w : arr[u].at(v)) {
+                    csr.targets.push_back(static_cast<uint32_t>(v));
+                    csr.weights.push_back(static_cast<double>(w));
+                }
+            }
+            csr.offsets.push_back(csr.targets.size());
+        }
+        // Colors section only when some color was set
+        if (pix_color.allocated()) {
+            csr.colors.resize(this->last_vert);
+            for (int v = 0; v < this->last_vert; v++) {
+                auto channel = [](int c) { return static_cast<uint8_t>(std::clamp(c, 0, 255)); };
+                const RGB& color = pix_color[v];
+                csr.colors[v] = graph_file::PixelColor{channel(color.r), channel(color.g), channel(color.b), 0};
+            }
+        }
+        return graph_file::write(path, csr, sizeof(W) <= sizeof(float));
     }
 
-	int vert_count() {
+    // Zero-copy view of a file written by save_binary
+    static MappedGraph open_mapped(const std::string& path, bool verify_checksums = false) {
+        return MappedGraph(path, verify_checksums);
+    }
+
+    // Rebuilds the adjacency lists (and pixel colors) from a mapped file
+    static BasicWeightedGraph from_mapped(const MappedGraph& mapped) {
+        int nVerts = mapped.vert_count();
+        BasicWeightedGraph res(nVerts, mapped.is_directed());
+        res.all_verts();
+        for (int u = 0; u < nVerts; u++) {
+            mapped.for_each_edge(u, [&](int v, double weight) {
+                W w = static_cast<W>(weight);
+                auto [slot, created] = res.arr.edit(u).try_emplace(v, w);
+                if (!created) slot->second.insert(w);
+            });
+            if (mapped.has_colors()) {
+                const graph_file::PixelColor& c = mapped.color(u);
+                res.pix_color.set(u, RGB(c.r, c.g, c.b));
+            }
+        }
+        return res;
+    }
+
+	int vert_count() const {
 		return last_vert;
 	}
 
-	WeightedGraph* clone(void) {
-		WeightedGraph* sub = new WeightedGraph(this->n);
-		sub->last_vert = this->last_vert;
-		sub->directed = this->directed;
-		sub->arr = this->arr;
-		sub->label = this->label;
-		return (sub);
+	// Snapshot with labels and pixel colors: shares the adjacency blocks,
+	// each side copies a block when it writes to it
+	BasicWeightedGraph* clone(void) {
+		return new BasicWeightedGraph(*this);
 	}
 
 	bool add_vert() {
@@ -523,7 +480,7 @@ public:
 
     bool add_vert(std::string label) {
         if (last_vert < n) {
-            this->label[last_vert++] = label;
+            this->label.set(last_vert++, label);
             return true;
         }
         return false;
@@ -532,7 +489,7 @@ public:
     void setLabel(int vert, std::string label)
     {
         if (vert <= last_vert) {
-            this->label[vert] = label;
+            this->label.set(vert, label);
         }
         else {
             throw std::invalid_argument("Vertex does not exist");
@@ -542,26 +499,33 @@ public:
     std::string getLabel(int vert)
     {
         if (vert <= last_vert) {
-            return (this->label[vert]);
+            return (this->label.get(vert));
         }
         else {
             throw std::invalid_argument("Vertex does not exist");
         }
     }
 
+    // First vertex with this label, or -1
+    int find_vert(const std::string& label) const {
+        return this->label.find(label);
+    }
+
     void all_verts(){
         while(add_vert()); // Adicionar todos os vertices possiveis
     }
 
     bool add_edge(int vert1, int vert2, double weight){
         if(vert1 <= last_vert && vert2 <= last_vert){
+            W w = static_cast<W>(weight);
 
             // Verifica se a aresta ja existe ou se esse peso ja existe
-            if ( (arr[vert1].count(vert2) == 0) || (std::count(arr[vert1][vert2].begin(), arr[vert1][vert2].end (), weight) == 0) )
+            auto [slot, created] = arr.edit(vert1).try_emplace(vert2, w);
+            if (created || slot->second.insert(w))
             { 
-                arr[vert1][vert2].push_back(weight);
                 if (!directed) {
-                    arr[vert2][vert1].push_back(weight);
+                    auto [back, back_created] = arr.edit(vert2).try_emplace(vert1, w);
+                    if (!back_created) back->second.insert(w);
                 }
                 return true; // Aresta adicionada
             }
@@ -585,9 +549,9 @@ public:
     bool remove_edge(int vert1, int vert2)
     {
         if (check_edge(vert1, vert2)) {
-            arr[vert1].erase(vert2);
+            arr.edit(vert1).erase(vert2);
             if (!directed) {
-                arr[vert2].erase(vert1);
+                arr.edit(vert2).erase(vert1);
             }
             return true;
         }
@@ -597,42 +561,47 @@ public:
 	std::vector<double> get_weight (int vert1, int vert2) {
 		std::vector<double> w = std::vector<double>();
 		if (check_edge(vert1, vert2)) {
-			w = arr[vert1][vert2];
+			const WeightSlot& slot = arr[vert1].at(vert2);
+			w.assign(slot.begin(), slot.end());
 		}
 		return (w);
 	}
 
+	// Calls fn(weight) for every weight of vert1 -> vert2, without copying the slot
+	template <typename Fn>
+	void for_each_weight (int vert1, int vert2, Fn fn) const {
+		if (vert1 >= last_vert || vert2 >= last_vert) return;
+		auto it = arr[vert1].find(vert2);
+		if (it != arr[vert1].end()) {
+			for (W w : it->second) {
+				fn(w);
+			}
+		}
+	}
+
     bool remove_edge(int vert1, int vert2, double weight) 
     {
         if(check_edge(vert1, vert2)) 
         {
-            if (arr[vert1][vert2].size() > 1) {
-                std::vector<double>* weight_list = &arr[vert1][vert2];
-                auto it = std::find(weight_list->begin(), weight_list->end(), weight);
-
-                if (it != weight_list->end()) {
-                    *it = weight_list->back();
-                    weight_list->pop_back();
+            W w = static_cast<W>(weight);
+            WeightSlot& slot = arr.edit(vert1).at(vert2);
+            if (slot.size() > 1) {
+                if (!slot.erase(w)) {
+                    return false; // There is no edge with the given weight
                 }
-                else return false; // There is no edge with the given weight
-
                 if (!directed) {
-                    std::vector<double>* weight_list = &arr[vert2][vert1];
-                    auto it = std::find(weight_list->begin(), weight_list->end(), weight);
-
-					*it = weight_list->back();	 	// Assuming that the weight was found based on the previous check
-					weight_list->pop_back();
-				}
-				return true;
-		}
-			else if (arr[vert1][vert2][0] == weight)
-			{
-				arr[vert1].erase(vert2);
-				if (!directed) {
-					arr[vert2].erase(vert1);
-				}
-				return true;
-			}
+                    arr.edit(vert2).at(vert1).erase(w); // Assuming that the weight was found based on the previous check
+                }
+                return true;
+            }
+            else if (slot.contains(w))
+            {
+                arr.edit(vert1).erase(vert2);
+                if (!directed) {
+                    arr.edit(vert2).erase(vert1);
+                }
+                return true;
+            }
         }
         return false;
     }
@@ -641,7 +610,19 @@ public:
 		return (arr[vert].size());
 	}
 
-    std::unordered_map<int, std::vector<double>> vert_neighbors(int vert) {
+	bool is_directed() const {
+		return directed;
+	}
+
+	// Calls fn(neighbor) for every neighbor of vert, without copying the adjacency map
+	template <typename Fn>
+	void for_each_neighbor (int vert, Fn fn) const {
+		for (const auto& entry : arr[vert]) {
+			fn(entry.first);
+		}
+	}
+
+    std::unordered_map<int, WeightSlot> vert_neighbors(int vert) {
         if(vert <= last_vert){
             return arr[vert];
         }
@@ -659,26 +640,26 @@ public:
         }
         // delete[] color;
         for (int i = 0; i < last_vert; i++) {
-            for (auto [neighbor, weight] : arr[i]) {
-                std::cout << i << " " << neighbor << " " << weight[0] << "\n";
+            for (const auto& [neighbor, weight] : arr[i]) {
+                std::cout << i << " " << neighbor << " " << static_cast<double>(weight.front()) << "\n";
             }
         }
     }
 
     void print_raw() const {
         for (int i = 0; i < last_vert; i++) {
-            if (label[i] != "") {
-                std::cout << i << " : \"" << label[i] << "\" ) | ";
+            if (!label.empty(i)) {
+                std::cout << i << " : \"" << label.get(i) << "\" ) | ";
             }
             else {
                 std::cout << i << " ) | ";
             }
-            for (auto [neighbor, weight_list] : arr[i]) {
+            for (const auto& [neighbor, weight_list] : arr[i]) {
                 std::cout << neighbor << "{";
-                int n = weight_list.size();
-                std::cout << weight_list[0];
-                for (int i = 1; i < n; i++) {
-                    std::cout << ", " << weight_list[i];
+                const W* w = weight_list.begin();
+                std::cout << static_cast<double>(*w);
+                for (w++; w != weight_list.end(); w++) {
+                    std::cout << ", " << static_cast<double>(*w);
                 }
                 std::cout << "} | ";
             }
@@ -688,6 +669,13 @@ public:
 
 };
 
-#endif
+// Multigraph with double weights (original behaviour)
+using WeightedGraph = BasicWeightedGraph<double, InlineWeights>;
 
+// Image graphs: one float weight per pixel pair. Distances rounded to float can
+// tie where the doubles differed (and the reverse), so Kruskal may merge equal
+// edges in another order: Felzenszwalb.ppm differs from the double version in a
+// handful of boundary pixels (8 pixels, 25 boundary pairs on elephant 240x160)
+using ImageGraph = BasicWeightedGraph<float, SingleWeight>;
 
+#endif
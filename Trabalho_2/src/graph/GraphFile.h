@@ -0,0 +1,342 @@
+#ifndef GRAPH_FILE_H
+#define GRAPH_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary graph file, read back with mmap instead of being parsed
+//
+// Layout (little-endian, every section 64-byte aligned):
+//   Header
+//   offsets  uint64 [vertex_count + 1]   CSR row starts
+//   targets  uint32 [edge_count]         neighbour of each adjacency entry
+//   weights  float or double [edge_count]
+//   colors   PixelColor [vertex_count]   only with HAS_COLORS
+// Undirected graphs store both directions, exactly like the adjacency lists.
+// Every section has its own checksum, and the header has one over itself.
+
+namespace graph_file {
+
+constexpr char MAGIC[8] = {'T', 'G', 'R', 'A', 'P', 'H', '\r', '\n'};
+constexpr uint32_t VERSION = 1;
+constexpr uint64_t ALIGNMENT = 64;
+
+enum Flags : uint32_t {
+    DIRECTED = 1u << 0,
+    HAS_COLORS = 1u << 1,
+    FLOAT_WEIGHTS = 1u << 2    // float instead of double
+};
+
+enum Section {
+    SECTION_OFFSETS,
+    SECTION_TARGETS,
+    SECTION_WEIGHTS,
+    SECTION_COLORS,
+    SECTION_COUNT
+};
+
+struct PixelColor {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t pad;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t vertex_count;
+    uint64_t edge_count;
+    uint64_t section_offset[SECTION_COUNT];  // Byte position in the file
+    uint64_t section_size[SECTION_COUNT];    // Bytes
+    uint64_t section_checksum[SECTION_COUNT];
+    uint64_t header_checksum;                // Over the bytes above
+};
+
+// FNV-1a over 64-bit words (bytes for the tail)
+inline uint64_t checksum(const void* data, uint64_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = 14695981039346656037ull;
+    uint64_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+inline uint64_t header_checksum(const Header& header) {
+    return checksum(&header, offsetof(Header, header_checksum));
+}
+
+inline uint64_t align(uint64_t position) {
+    return (position + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// CSR arrays in memory, as produced by save_binary of each graph class
+struct Csr {
+    bool directed = false;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<double> weights;
+    std::vector<PixelColor> colors;    // Empty when the graph has none
+};
+
+// Writes csr to path; false when the file cannot be written
+inline bool write(const std::string& path, const Csr& csr, bool float_weights) {
+    uint64_t n = csr.offsets.empty() ? 0 : csr.offsets.size() - 1;
+    uint64_t m = csr.targets.size();
+    if (csr.weights.size() != m || (!csr.colors.empty() && csr.colors.size() != n)) {
+        throw std::invalid_argument("Inconsistent CSR arrays");
+    }
+
+    std::vector<float> narrow;
+    if (float_weights) {
+        narrow.assign(csr.weights.begin(), csr.weights.end());
+    }
+    const void* data[SECTION_COUNT] = {
+        csr.offsets.data(), csr.targets.data(),
+        float_weights ? static_cast<const void*>(narrow.data()) : static_cast<const void*>(csr.weights.data()),
+        csr.colors.data()
+    };
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.flags = (csr.directed ? static_cast<uint32_t>(DIRECTED) : 0u) |
+                   (csr.colors.empty() ? 0u : static_cast<uint32_t>(HAS_COLORS)) |
+                   (float_weights ? static_cast<uint32_t>(FLOAT_WEIGHTS) : 0u);
+    header.vertex_count = n;
+    header.edge_count = m;
+    header.section_size[SECTION_OFFSETS] = csr.offsets.size() * sizeof(uint64_t);
+    header.section_size[SECTION_TARGETS] = m * sizeof(uint32_t);
+    header.section_size[SECTION_WEIGHTS] = m * (float_weights ? sizeof(float) : sizeof(double));
+    header.section_size[SECTION_COLORS] = csr.colors.size() * sizeof(PixelColor);
+    uint64_t position = align(sizeof(Header));
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        header.section_offset[s] = position;
+        header.section_checksum[s] = checksum(data[s], header.section_size[s]);
+        position = align(position + header.section_size[s]);
+    }
+    header.header_checksum = header_checksum(header);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    const char zeros[ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    uint64_t written = sizeof(Header);
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        file.write(zeros, header.section_offset[s] - written);
+        file.write(static_cast<const char*>(data[s]), header.section_size[s]);
+        written = header.section_offset[s] + header.section_size[s];
+    }
+    return static_cast<bool>(file);
+}
+
+}
+
+// Read-only view of a graph file mapped into memory
+// Pages are loaded on first touch; the arrays point straight into the mapping
+class MappedGraph {
+
+private:
+
+    void* base;
+    uint64_t length;
+    const graph_file::Header* header;
+
+    void unmap() {
+        if (base != nullptr) {
+            munmap(base, length);
+        }
+        base = nullptr;
+        length = 0;
+        header = nullptr;
+    }
+
+    int checked_target(uint32_t target) const {
+        if (target >= header->vertex_count) {
+            throw std::runtime_error("graph file: edge target out of range");
+        }
+        return static_cast<int>(target);
+    }
+
+    template <typename T>
+    const T* section(int s) const {
+        return reinterpret_cast<const T*>(static_cast<const char*>(base) + header->section_offset[s]);
+    }
+
+    void validate(const std::string& path, bool verify_checksums) const {
+        using namespace graph_file;
+        auto fail = [&](const std::string& why) {
+            throw std::runtime_error(path + ": " + why);
+        };
+        if (length < sizeof(Header) || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+            fail("not a graph file");
+        }
+        if (header->version != VERSION) {
+            fail("unsupported graph file version " + std::to_string(header->version));
+        }
+        if (header->header_checksum != header_checksum(*header)) {
+            fail("corrupted header");
+        }
+        uint64_t n = header->vertex_count, m = header->edge_count;
+        uint64_t expected[SECTION_COUNT] = {
+            (n + 1) * sizeof(uint64_t), m * sizeof(uint32_t),
+            m * ((header->flags & FLOAT_WEIGHTS) ? sizeof(float) : sizeof(double)),
+            (header->flags & HAS_COLORS) ? n * sizeof(PixelColor) : 0
+        };
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            uint64_t offset = header->section_offset[s], size = header->section_size[s];
+            if (size != expected[s] || offset % ALIGNMENT != 0 || offset > length || size > length - offset) {
+                fail("truncated or malformed section");
+            }
+            if (verify_checksums && checksum(static_cast<const char*>(base) + offset, size) != header->section_checksum[s]) {
+                fail("checksum mismatch");
+            }
+        }
+        // Row bounds are always checked (O(n)): every read goes through them
+        const uint64_t* offsets = section<uint64_t>(SECTION_OFFSETS);
+        if (offsets[0] != 0 || offsets[n] != m) {
+            fail("malformed offsets");
+        }
+        for (uint64_t v = 0; v < n; v++) {
+            if (offsets[v] > offsets[v + 1]) fail("malformed offsets");
+        }
+        if (verify_checksums) {
+            const uint32_t* targets = section<uint32_t>(SECTION_TARGETS);
+            for (uint64_t e = 0; e < m; e++) {
+                if (targets[e] >= n) fail("edge target out of range");
+            }
+        }
+    }
+
+public:
+
+    // Throws std::runtime_error when the file is missing, truncated or corrupted
+    // By default only the header and the row offsets are read before the first access;
+    // verify_checksums also checksums every section and range-checks the targets (O(file size))
+    explicit MappedGraph(const std::string& path, bool verify_checksums = false)
+    : base(nullptr), length(0), header(nullptr) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error(path + ": cannot open");
+        }
+        struct stat info;
+        if (fstat(fd, &info) == -1 || info.st_size == 0) {
+            close(fd);
+            throw std::runtime_error(path + ": not a graph file");
+        }
+        length = static_cast<uint64_t>(info.st_size);
+        base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            base = nullptr;
+            throw std::runtime_error(path + ": mmap failed");
+        }
+        header = static_cast<const graph_file::Header*>(base);
+        try {
+            validate(path, verify_checksums);
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    MappedGraph(const MappedGraph&) = delete;
+    MappedGraph& operator= (const MappedGraph&) = delete;
+
+    MappedGraph(MappedGraph&& other) noexcept
+    : base(std::exchange(other.base, nullptr)), length(std::exchange(other.length, 0)),
+      header(std::exchange(other.header, nullptr)) {}
+
+    MappedGraph& operator= (MappedGraph&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            base = std::exchange(other.base, nullptr);
+            length = std::exchange(other.length, 0);
+            header = std::exchange(other.header, nullptr);
+        }
+        return *this;
+    }
+
+    ~MappedGraph() {
+        unmap();
+    }
+
+    int vert_count() const {
+        return static_cast<int>(header->vertex_count);
+    }
+
+    uint64_t edge_count() const {
+        return header->edge_count;
+    }
+
+    bool is_directed() const {
+        return header->flags & graph_file::DIRECTED;
+    }
+
+    bool has_colors() const {
+        return header->flags & graph_file::HAS_COLORS;
+    }
+
+    const uint64_t* offsets() const {
+        return section<uint64_t>(graph_file::SECTION_OFFSETS);
+    }
+
+    const uint32_t* targets() const {
+        return section<uint32_t>(graph_file::SECTION_TARGETS);
+    }
+
+    double weight(uint64_t entry) const {
+        if (header->flags & graph_file::FLOAT_WEIGHTS) {
+            return section<float>(graph_file::SECTION_WEIGHTS)[entry];
+        }
+        return section<double>(graph_file::SECTION_WEIGHTS)[entry];
+    }
+
+    // Valid only when has_colors()
+    const graph_file::PixelColor& color(int v) const {
+        return section<graph_file::PixelColor>(graph_file::SECTION_COLORS)[v];
+    }
+
+    // Targets are range-checked here as they are read (on open only with verify_checksums)
+    template <typename Fn>
+    void for_each_neighbor(int v, Fn fn) const {
+        const uint64_t* row = offsets();
+        const uint32_t* target = targets();
+        for (uint64_t e = row[v]; e < row[v + 1]; e++) {
+            fn(checked_target(target[e]));
+        }
+    }
+
+    // fn(target, weight) for every adjacency entry of v
+    template <typename Fn>
+    void for_each_edge(int v, Fn fn) const {
+        const uint64_t* row = offsets();
+        const uint32_t* target = targets();
+        for (uint64_t e = row[v]; e < row[v + 1]; e++) {
+            fn(checked_target(target[e]), weight(e));
+        }
+    }
+};
+
+#endif
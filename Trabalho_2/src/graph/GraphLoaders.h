@@ -0,0 +1,379 @@
+#ifndef GRAPH_LOADERS_H
+#define GRAPH_LOADERS_H
+
+#include "Generators.h"
+#include "GraphFile.h"
+#include "../util/ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Loaders for directed graphs in common text formats
+//
+//   DIMACS .gr       "p sp n m" then m "a u v w" lines, ids from 1; "c" lines are comments
+//   SNAP edge list   "u v" or "u v w" per line, ids from 0, "#" comments; n = largest id + 1
+//   Matrix Market    "%%MatrixMarket matrix coordinate real|integer|pattern
+//                    general|symmetric|skew-symmetric", "%" comments, "rows cols nnz",
+//                    then nnz "i j [w]" lines from 1 (i -> j); symmetric files get both
+//                    directions (j -> i with -w when skew-symmetric), pattern files weight 1
+//
+// The file is mapped with mmap and the body is cut into one chunk per task, each
+// moved forward to the next line start. Chunks are parsed in parallel with
+// std::from_chars into their own edge lists. The lists are then concatenated into
+// generators::EdgeArrays and handed to generators::build_csr. So duplicate pairs
+// keep their lightest weight and self-loops are dropped, as for the generators.
+// Malformed input throws std::runtime_error with the byte position of the first
+// bad line; a number of arc or entry lines other than the header's m or nnz throws
+// as well.
+
+namespace graph_loaders {
+
+enum class Format {
+    DIMACS,
+    SNAP,
+    MATRIX_MARKET
+};
+
+// .gr -> DIMACS, .mtx -> Matrix Market, anything else -> SNAP edge list
+inline Format format_of(const std::string& path) {
+    auto ends_with = [&](const char* suffix) {
+        size_t length = std::strlen(suffix);
+        return path.size() >= length && path.compare(path.size() - length, length, suffix) == 0;
+    };
+    if (ends_with(".gr")) return Format::DIMACS;
+    if (ends_with(".mtx")) return Format::MATRIX_MARKET;
+    return Format::SNAP;
+}
+
+// Read-only mapping of a whole file
+class MappedText {
+
+private:
+
+    void* base = nullptr;
+    size_t length = 0;
+
+public:
+
+    explicit MappedText(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error(path + ": cannot open");
+        }
+        struct stat info;
+        if (fstat(fd, &info) == -1) {
+            close(fd);
+            throw std::runtime_error(path + ": cannot stat");
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (base == MAP_FAILED) {
+            base = nullptr;
+            throw std::runtime_error(path + ": mmap failed");
+        }
+        if (base != nullptr) {
+            madvise(base, length, MADV_SEQUENTIAL);
+        }
+    }
+
+    MappedText(const MappedText&) = delete;
+    MappedText& operator= (const MappedText&) = delete;
+
+    ~MappedText() {
+        if (base != nullptr) {
+            munmap(base, length);
+        }
+    }
+
+    const char* begin() const {
+        return static_cast<const char*>(base);
+    }
+
+    const char* end() const {
+        return begin() + length;
+    }
+};
+
+namespace detail {
+
+inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skip_blanks(const char* p, const char* end) {
+    while (p < end && is_blank(*p)) p++;
+    return p;
+}
+
+inline const char* next_line(const char* p, const char* end) {
+    const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return newline == nullptr ? end : newline + 1;
+}
+
+// Reads one number and the blanks after it; false when there is none
+template <typename T>
+bool read(const char*& p, const char* end, T& value) {
+    auto [next, error] = std::from_chars(p, end, value);
+    if (error != std::errc() || (next < end && !is_blank(*next) && *next != '\n')) {
+        return false;
+    }
+    p = skip_blanks(next, end);
+    return true;
+}
+
+// Edges of one chunk
+struct Chunk {
+    std::vector<uint32_t> source;
+    std::vector<uint32_t> target;
+    std::vector<double> weight;
+    uint32_t max_id = 0;
+    int64_t lines = 0;              // Arc or entry lines, before symmetric mirroring
+    const char* error = nullptr;
+
+    void add(uint32_t u, uint32_t v, double w) {
+        source.push_back(u);
+        target.push_back(v);
+        weight.push_back(w);
+        max_id = std::max({max_id, u, v});
+    }
+};
+
+// Parses [body, end) with parse_line(line, line_end, chunk) -> bool on every line, in parallel
+template <typename LineFn>
+std::vector<Chunk> parse_chunks(const char* body, const char* end, LineFn parse_line, ThreadPool& pool) {
+    constexpr size_t MIN_CHUNK = 1 << 20;
+    size_t size = end - body;
+    size_t count = std::max<size_t>(1, std::min<size_t>(pool.size() * 4, size / MIN_CHUNK));
+
+    std::vector<const char*> cut(count + 1, end);
+    cut[0] = body;
+    for (size_t c = 1; c < count; c++) {
+        const char* at = std::max(cut[c - 1], body + size / count * c);
+        cut[c] = at == body ? body : next_line(at - 1, end);
+    }
+
+    std::vector<Chunk> chunks(count);
+    pool.parallel_for(0, static_cast<int>(count), [&](int lo, int hi) {
+        for (int c = lo; c < hi; c++) {
+            Chunk& chunk = chunks[c];
+            // About 16 bytes per line in typical edge lists
+            chunk.source.reserve((cut[c + 1] - cut[c]) / 16);
+            chunk.target.reserve((cut[c + 1] - cut[c]) / 16);
+            chunk.weight.reserve((cut[c + 1] - cut[c]) / 16);
+            for (const char* line = cut[c]; line < cut[c + 1]; ) {
+                const char* line_end = next_line(line, cut[c + 1]);
+                const char* p = skip_blanks(line, line_end);
+                if (p < line_end && *p != '\n' && !parse_line(p, line_end, chunk)) {
+                    chunk.error = line;
+                    break;
+                }
+                line = line_end;
+            }
+        }
+    }, 1);
+    return chunks;
+}
+
+// Concatenates the chunks; vertices == 0 means largest id + 1, declared_lines < 0
+// skips the check against the header's arc or entry count
+inline generators::EdgeArrays merge(std::vector<Chunk>& chunks, int64_t vertices, int64_t declared_lines,
+                                    const char* file_begin, const std::string& path, ThreadPool& pool) {
+    int64_t lines = 0;
+    for (const Chunk& chunk : chunks) {
+        if (chunk.error != nullptr) {
+            throw std::runtime_error(path + ": malformed line at byte " + std::to_string(chunk.error - file_begin));
+        }
+        lines += chunk.lines;
+    }
+    if (declared_lines >= 0 && lines != declared_lines) {
+        throw std::runtime_error(path + ": header declares " + std::to_string(declared_lines) + " edges, found "
+                                 + std::to_string(lines));
+    }
+    std::vector<int64_t> start(chunks.size() + 1, 0);
+    uint32_t max_id = 0;
+    for (size_t c = 0; c < chunks.size(); c++) {
+        start[c + 1] = start[c] + chunks[c].source.size();
+        max_id = std::max(max_id, chunks[c].max_id);
+    }
+
+    generators::EdgeArrays edges;
+    if (vertices == 0 && start.back() > 0) {
+        vertices = static_cast<int64_t>(max_id) + 1;
+    }
+    if (vertices > INT32_MAX) {
+        throw std::runtime_error(path + ": too many vertices");
+    }
+    if (start.back() > 0 && max_id >= vertices) {
+        throw std::runtime_error(path + ": vertex id " + std::to_string(max_id) + " out of range");
+    }
+    edges.vertices = static_cast<int>(vertices);
+    edges.resize(start.back());
+    pool.parallel_for(0, static_cast<int>(chunks.size()), [&](int lo, int hi) {
+        for (int c = lo; c < hi; c++) {
+            std::copy(chunks[c].source.begin(), chunks[c].source.end(), edges.source.begin() + start[c]);
+            std::copy(chunks[c].target.begin(), chunks[c].target.end(), edges.target.begin() + start[c]);
+            std::copy(chunks[c].weight.begin(), chunks[c].weight.end(), edges.weight.begin() + start[c]);
+            chunks[c] = Chunk();
+        }
+    }, 1);
+    return edges;
+}
+
+}
+
+inline generators::EdgeArrays read_dimacs(const std::string& path, ThreadPool& pool = ThreadPool::shared()) {
+    using namespace detail;
+    MappedText text(path);
+    const char* end = text.end();
+
+    // Header: comments up to the "p sp n m" line
+    int64_t vertices = -1;
+    int64_t arcs = -1;
+    const char* body = text.begin();
+    while (body < end && vertices < 0) {
+        const char* line_end = next_line(body, end);
+        const char* p = skip_blanks(body, line_end);
+        if (p < line_end && *p == 'p') {
+            p = skip_blanks(p + 1, line_end);
+            while (p < line_end && !is_blank(*p) && *p != '\n') p++;    // "sp"
+            p = skip_blanks(p, line_end);
+            uint64_t n = 0, m = 0;
+            if (!read(p, line_end, n) || !read(p, line_end, m)) {
+                throw std::runtime_error(path + ": malformed problem line");
+            }
+            vertices = static_cast<int64_t>(n);
+            arcs = static_cast<int64_t>(m);
+        } else if (p < line_end && *p != 'c' && *p != '\n') {
+            throw std::runtime_error(path + ": arc before the problem line");
+        }
+        body = line_end;
+    }
+    if (vertices < 0) {
+        throw std::runtime_error(path + ": missing problem line");
+    }
+
+    auto chunks = parse_chunks(body, end, [](const char* p, const char* line_end, Chunk& chunk) {
+        if (*p == 'c') return true;
+        if (*p != 'a') return false;
+        p = skip_blanks(p + 1, line_end);
+        uint32_t u = 0, v = 0;
+        double w = 0.0;
+        if (!read(p, line_end, u) || !read(p, line_end, v) || !read(p, line_end, w) || u == 0 || v == 0) {
+            return false;
+        }
+        chunk.add(u - 1, v - 1, w);
+        chunk.lines++;
+        return p == line_end || *p == '\n';
+    }, pool);
+    return merge(chunks, vertices, arcs, text.begin(), path, pool);
+}
+
+inline generators::EdgeArrays read_snap(const std::string& path, ThreadPool& pool = ThreadPool::shared()) {
+    using namespace detail;
+    MappedText text(path);
+    auto chunks = parse_chunks(text.begin(), text.end(), [](const char* p, const char* line_end, Chunk& chunk) {
+        if (*p == '#' || *p == '%') return true;
+        uint32_t u = 0, v = 0;
+        double w = 1.0;
+        if (!read(p, line_end, u) || !read(p, line_end, v)) {
+            return false;
+        }
+        if (p < line_end && *p != '\n' && !read(p, line_end, w)) {
+            return false;
+        }
+        chunk.add(u, v, w);
+        return p == line_end || *p == '\n';
+    }, pool);
+    return merge(chunks, 0, -1, text.begin(), path, pool);
+}
+
+inline generators::EdgeArrays read_matrix_market(const std::string& path, ThreadPool& pool = ThreadPool::shared()) {
+    using namespace detail;
+    MappedText text(path);
+    const char* end = text.end();
+
+    const char* body = text.begin();
+    const char* banner_end = next_line(body, end);
+    std::string banner(body, banner_end);
+    std::transform(banner.begin(), banner.end(), banner.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (banner.rfind("%%matrixmarket matrix coordinate", 0) != 0) {
+        throw std::runtime_error(path + ": not a coordinate Matrix Market file");
+    }
+    bool pattern = banner.find(" pattern") != std::string::npos;
+    bool skew = banner.find(" skew-symmetric") != std::string::npos;
+    bool symmetric = skew || banner.find(" symmetric") != std::string::npos || banner.find(" hermitian") != std::string::npos;
+    if (banner.find(" complex") != std::string::npos) {
+        throw std::runtime_error(path + ": complex matrices are not supported");
+    }
+
+    // Comments, then "rows cols nnz"
+    int64_t vertices = -1;
+    int64_t entries = -1;
+    body = banner_end;
+    while (body < end && vertices < 0) {
+        const char* line_end = next_line(body, end);
+        const char* p = skip_blanks(body, line_end);
+        if (p < line_end && *p != '%' && *p != '\n') {
+            uint64_t rows = 0, cols = 0, nnz = 0;
+            if (!read(p, line_end, rows) || !read(p, line_end, cols) || !read(p, line_end, nnz)) {
+                throw std::runtime_error(path + ": malformed size line");
+            }
+            vertices = static_cast<int64_t>(std::max(rows, cols));
+            entries = static_cast<int64_t>(nnz);
+        }
+        body = line_end;
+    }
+    if (vertices < 0) {
+        throw std::runtime_error(path + ": missing size line");
+    }
+
+    auto chunks = parse_chunks(body, end, [pattern, symmetric, skew](const char* p, const char* line_end, Chunk& chunk) {
+        if (*p == '%') return true;
+        uint32_t i = 0, j = 0;
+        double w = 1.0;
+        if (!read(p, line_end, i) || !read(p, line_end, j) || (!pattern && !read(p, line_end, w)) || i == 0 || j == 0) {
+            return false;
+        }
+        chunk.add(i - 1, j - 1, w);
+        chunk.lines++;
+        if (symmetric && i != j) {
+            chunk.add(j - 1, i - 1, skew ? -w : w);
+        }
+        return p == line_end || *p == '\n';
+    }, pool);
+    return merge(chunks, vertices, entries, text.begin(), path, pool);
+}
+
+inline generators::EdgeArrays read_edges(const std::string& path, Format format, ThreadPool& pool = ThreadPool::shared()) {
+    switch (format) {
+        case Format::DIMACS: return read_dimacs(path, pool);
+        case Format::MATRIX_MARKET: return read_matrix_market(path, pool);
+        default: return read_snap(path, pool);
+    }
+}
+
+// Directed CSR of the file (see generators::build_csr)
+inline graph_file::Csr load_csr(const std::string& path, Format format, ThreadPool& pool = ThreadPool::shared()) {
+    return generators::build_csr(read_edges(path, format, pool), pool);
+}
+
+inline graph_file::Csr load_csr(const std::string& path, ThreadPool& pool = ThreadPool::shared()) {
+    return load_csr(path, format_of(path), pool);
+}
+
+}
+
+#endif
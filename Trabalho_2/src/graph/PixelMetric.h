@@ -0,0 +1,78 @@
+#ifndef PIXEL_METRIC_H
+#define PIXEL_METRIC_H
+
+#include "Features.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Edge weight functors over two PixelFeature values
+// The graph builders are templates on the metric, so the call is inlined and
+// there is no per-edge dispatch or allocation. Any callable
+// double(const PixelFeature&, const PixelFeature&) works as a user metric;
+// metrics that read L/A/B declare `static constexpr bool uses_lab = true`
+// (checked with pixel_metric::uses_lab, in Features.h).
+
+namespace pixel_metric {
+
+// rgb_diff
+struct RgbEuclidean {
+    double operator()(const PixelFeature &p, const PixelFeature &q) const {
+        int rdiff = std::abs(p.r - q.r),
+            gdiff = std::abs(p.g - q.g),
+            bdiff = std::abs(p.b - q.b);
+        return std::sqrt(rdiff * rdiff + gdiff * gdiff + bdiff * bdiff);
+    }
+};
+
+// lab_distance
+struct Lab {
+    static constexpr bool uses_lab = true;
+
+    double operator()(const PixelFeature &p, const PixelFeature &q) const {
+        float dL = p.L - q.L;
+        float da = p.A - q.A;
+        float db = p.B - q.B;
+        return std::sqrt(dL * dL + da * da + db * db);
+    }
+};
+
+// Largest per-channel difference
+struct MaxChannel {
+    double operator()(const PixelFeature &p, const PixelFeature &q) const {
+        return std::max({std::abs(p.r - q.r), std::abs(p.g - q.g), std::abs(p.b - q.b)});
+    }
+};
+
+// from_ppm_matrix: a color metric plus brightness_scale times the largest channel
+// of the two pixels (rgb_max)
+template <typename Color = RgbEuclidean>
+struct BrightnessBlended {
+    static constexpr bool uses_lab = pixel_metric::uses_lab<Color>;
+
+    double brightness_scale;
+    Color color{};
+
+    double operator()(const PixelFeature &p, const PixelFeature &q) const {
+        return color(p, q) + brightness_scale * std::max({p.r, p.g, p.b, q.r, q.g, q.b});
+    }
+};
+
+// color_gradient_weight: a color metric blended with the mean gradient
+template <typename Color = RgbEuclidean>
+struct GradientBlended {
+    static constexpr bool uses_lab = pixel_metric::uses_lab<Color>;
+
+    double color_scale;
+    double gradient_scale;
+    Color color{};
+
+    double operator()(const PixelFeature &p, const PixelFeature &q) const {
+        double grad_weight = (p.gradient + q.gradient) * 0.5 * 100.0;
+        return color_scale * color(p, q) + gradient_scale * grad_weight;
+    }
+};
+
+}
+
+#endif
@@ -8,7 +8,7 @@
 #include <stdio.h>
 #include <iostream>
 
-inline double rgb_diff(std::vector<int> v1, std::vector<int> v2) {
+inline double rgb_diff(const std::vector<int>& v1, const std::vector<int>& v2) {
     int rdiff = std::abs(v1[0] - v2[0]),
         gdiff = std::abs(v1[1] - v2[1]),
         bdiff = std::abs(v1[2] - v2[2]);
@@ -68,13 +68,40 @@ inline double lab_distance(const std::array<double, 3>& lab1, const std::array<d
     return std::sqrt(dL * dL + da * da + db * db);
 }
 
-inline int rgb_max(std::vector<int> v1, std::vector<int> v2) {
+inline int rgb_max(const std::vector<int>& v1, const std::vector<int>& v2) {
 	int rmax = std::max(v1[0], v2[0]);
 	int gmax = std::max(v1[1], v2[1]);
 	int bmax = std::max(v1[2], v2[2]);
 	return std::max(rmax, std::max(gmax, bmax));
 }
 
+// Magnitude of a Sobel output pixel, normalized to [0, 1]
+inline double gradient_magnitude(const std::vector<int> &pixel) {
+    if (pixel.empty()) {
+        return 0.0;
+    }
+    double sum_sq = 0.0;
+    for (int channel_value : pixel) {
+        sum_sq += static_cast<double>(channel_value) * static_cast<double>(channel_value);
+    }
+    double denominator = std::sqrt(static_cast<double>(std::max<size_t>(1, pixel.size()))) * 255.0;
+    if (denominator == 0.0) {
+        return 0.0;
+    }
+    return std::sqrt(sum_sq) / denominator;
+}
+
+// Edge weight of from_color_and_gradient: color distance blended with the mean gradient
+inline double color_gradient_weight(
+    const std::vector<int> &color1, const std::vector<int> &color2,
+    double gradient1, double gradient2,
+    double color_scale, double gradient_scale
+) {
+    double color_diff = rgb_diff(color1, color2);
+    double grad_weight = (gradient1 + gradient2) * 0.5 * 100.0;
+    return color_scale * color_diff + gradient_scale * grad_weight;
+}
+
 inline void print_ppm(std::vector<std::vector<std::vector<int>>> &image, int width, int height) {
     int nVerts = width * height;
     std::cout << "vec1 len = " << image.size() << "\nvec2 len = " << image[0].size() << std::endl;
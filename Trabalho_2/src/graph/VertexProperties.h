@@ -0,0 +1,205 @@
+#ifndef VERTEX_PROPERTIES_H
+#define VERTEX_PROPERTIES_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-vertex data allocated on first write
+//
+// A graph used to carry a std::string label and an RGB for every vertex from
+// construction on, whether anything was ever stored there or not (32 bytes
+// per vertex for the strings alone, ~640 MB on a 20 MP image). A
+// VertexProperty holds nothing until the first set(); reads before that return
+// the default value.
+//
+// DENSE keeps a vector of n values once written (pixel colors: every vertex
+// gets one). SPARSE keeps a hash map of the vertices written so far and turns
+// dense when more than 1/8 of them are set, where the map stops being smaller.
+
+template <typename T>
+class VertexProperty {
+
+public:
+
+    enum Layout { DENSE, SPARSE };
+
+private:
+
+    int n;
+    Layout layout;
+    T fallback;
+    std::vector<T> dense;               // Empty until written (or while sparse)
+    std::unordered_map<int, T> sparse;
+
+    void densify() {
+        dense.assign(n, fallback);
+        for (const auto& [v, value] : sparse) dense[v] = value;
+        sparse = {};
+        layout = DENSE;
+    }
+
+public:
+
+    explicit VertexProperty(int n = 0, Layout layout = DENSE, T fallback = T())
+    : n(n), layout(layout), fallback(fallback) {}
+
+    bool allocated() const {
+        return !dense.empty() || !sparse.empty();
+    }
+
+    bool has(int v) const {
+        if (!dense.empty()) return true;
+        return sparse.count(v) > 0;
+    }
+
+    const T& operator[] (int v) const {
+        if (!dense.empty()) return dense[v];
+        if (sparse.empty()) return fallback;
+        auto it = sparse.find(v);
+        return it == sparse.end() ? fallback : it->second;
+    }
+
+    void set(int v, const T& value) {
+        if (layout == DENSE) {
+            data()[v] = value;
+            return;
+        }
+        sparse[v] = value;
+        if (sparse.size() > static_cast<size_t>(n) / 8) densify();
+    }
+
+    // Dense storage for bulk writes (allocates it, turning a sparse map dense);
+    // writes through it from several threads are fine, allocation is not
+    T* data() {
+        if (dense.empty() && n > 0) densify();
+        return dense.data();
+    }
+
+    // Every value, written or not
+    std::vector<T> to_vector() const {
+        if (!dense.empty()) return dense;
+        std::vector<T> values(n, fallback);
+        for (const auto& [v, value] : sparse) values[v] = value;
+        return values;
+    }
+
+    void assign(const std::vector<T>& values) {
+        dense = values;
+        dense.resize(n, fallback);
+        sparse = {};
+        layout = DENSE;
+    }
+
+    // Written vertices with their values: fn(v, value)
+    template <typename Fn>
+    void for_each(Fn fn) const {
+        if (!dense.empty()) {
+            for (int v = 0; v < n; v++) fn(v, dense[v]);
+        }
+        for (const auto& [v, value] : sparse) fn(v, value);
+    }
+
+    void clear() {
+        dense = {};
+        sparse = {};
+    }
+};
+
+// Interned strings: each distinct string is stored once and vertices refer to
+// it by a 32-bit id. Id 0 is the empty string
+class StringTable {
+
+private:
+
+    std::vector<std::string> strings{""};
+    std::unordered_map<std::string, uint32_t> ids{{"", 0}};
+
+public:
+
+    uint32_t intern(const std::string& text) {
+        auto [it, created] = ids.try_emplace(text, static_cast<uint32_t>(strings.size()));
+        if (created) strings.push_back(text);
+        return it->second;
+    }
+
+    // Id of text, or -1 when it was never interned
+    int64_t find(const std::string& text) const {
+        auto it = ids.find(text);
+        return it == ids.end() ? -1 : it->second;
+    }
+
+    const std::string& str(uint32_t id) const {
+        return strings[id];
+    }
+
+    size_t size() const {
+        return strings.size();
+    }
+};
+
+// Vertex names: a sparse id property over an interned table. find() reads the
+// smallest vertex of each id from `first`; only renaming that vertex while other
+// vertices keep the name costs a scan for the next one
+class VertexLabels {
+
+private:
+
+    VertexProperty<uint32_t> id;
+    StringTable table;
+    std::vector<int> first;     // Smallest vertex named by each id, -1 for none
+    std::vector<int> count;     // Vertices named by each id
+
+    // Id old no longer names v
+    void forget(int v, uint32_t old) {
+        if (--count[old] == 0) {
+            first[old] = -1;
+        }
+        else if (first[old] == v) {
+            int next = -1;
+            id.for_each([&](int u, uint32_t value) {
+                if (value == old && u != v && (next == -1 || u < next)) next = u;
+            });
+            first[old] = next;
+        }
+    }
+
+public:
+
+    explicit VertexLabels(int n = 0)
+    : id(n, VertexProperty<uint32_t>::SPARSE) {}
+
+    void set(int v, const std::string& label) {
+        if (label.empty() && !id.has(v)) return;
+        uint32_t old = id[v];
+        uint32_t now = table.intern(label);
+        if (old == now) return;
+        if (old != 0) forget(v, old);
+        id.set(v, now);
+        if (now == 0) return;
+        if (now >= first.size()) {
+            first.resize(now + 1, -1);
+            count.resize(now + 1, 0);
+        }
+        count[now]++;
+        if (first[now] == -1 || v < first[now]) first[now] = v;
+    }
+
+    const std::string& get(int v) const {
+        return table.str(id[v]);
+    }
+
+    bool empty(int v) const {
+        return id[v] == 0;
+    }
+
+    // First vertex named label, or -1
+    int find(const std::string& label) const {
+        int64_t wanted = table.find(label);
+        if (wanted <= 0 || wanted >= static_cast<int64_t>(first.size())) return -1;
+        return first[wanted];
+    }
+};
+
+#endif
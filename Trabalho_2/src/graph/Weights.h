@@ -0,0 +1,174 @@
+#ifndef WEIGHTS_H
+#define WEIGHTS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Weight types and multiplicity policies for BasicWeightedGraph
+
+// uint16 fixed-point weight with 6 fractional bits (range 0 .. ~1023.98)
+// Enough for every image metric we use (rgb_diff tops out at ~441)
+struct Fixed16 {
+    static constexpr int FRACTION_BITS = 6;
+    static constexpr double SCALE = 1 << FRACTION_BITS;
+
+    uint16_t raw;
+
+    Fixed16()
+    : raw(0) {}
+
+    Fixed16(double value)
+    : raw(quantize(value)) {}
+
+    operator double() const {
+        return raw / SCALE;
+    }
+
+private:
+
+    static uint16_t quantize(double value) {
+        double scaled = std::round(value * SCALE);
+        if (scaled <= 0.0) return 0;
+        if (scaled >= UINT16_MAX) return UINT16_MAX; // Saturates instead of wrapping
+        return static_cast<uint16_t>(scaled);
+    }
+};
+
+// Exactly one weight per (u, v) pair, stored inline
+// A second add_edge on the same pair is rejected, like Graph::add_edge
+template <typename W>
+class SingleWeight {
+
+private:
+
+    W value;
+
+public:
+
+    SingleWeight(W w)
+    : value(w) {}
+
+    bool insert(W) { return false; }
+
+    bool contains(W w) const { return value == w; }
+
+    // Only one weight: the caller drops the whole slot instead
+    bool erase(W w) { return contains(w); }
+
+    int size() const { return 1; }
+    bool empty() const { return false; }
+
+    W front() const { return value; }
+    W min() const { return value; }
+
+    const W* begin() const { return &value; }
+    const W* end() const { return &value + 1; }
+};
+
+// Set of distinct weights per (u, v) pair (parallel edges)
+// The first INLINE_CAPACITY weights live in the slot itself, the rest spill to the heap
+template <typename W>
+class InlineWeights {
+
+public:
+
+    static constexpr int INLINE_CAPACITY = 2;
+
+private:
+
+    W local[INLINE_CAPACITY];
+    int count;
+    std::unique_ptr<std::vector<W>> spill; // Once set, holds every weight of the slot
+
+public:
+
+    InlineWeights(W w)
+    : local{}, count(1) {
+        local[0] = w;
+    }
+
+    InlineWeights(const InlineWeights& other)
+    : count(other.count), spill(other.spill ? new std::vector<W>(*other.spill) : nullptr) {
+        std::copy(other.local, other.local + INLINE_CAPACITY, local);
+    }
+
+    // The source is left empty: with its spill gone, a count above INLINE_CAPACITY
+    // would make begin()/end() run past local
+    InlineWeights(InlineWeights&& other) noexcept
+    : count(other.count), spill(std::move(other.spill)) {
+        std::copy(other.local, other.local + INLINE_CAPACITY, local);
+        other.count = 0;
+    }
+
+    InlineWeights& operator= (const InlineWeights& other) {
+        if (this != &other) {
+            std::copy(other.local, other.local + INLINE_CAPACITY, local);
+            count = other.count;
+            spill.reset(other.spill ? new std::vector<W>(*other.spill) : nullptr);
+        }
+        return *this;
+    }
+
+    InlineWeights& operator= (InlineWeights&& other) noexcept {
+        if (this != &other) {
+            std::copy(other.local, other.local + INLINE_CAPACITY, local);
+            count = other.count;
+            spill = std::move(other.spill);
+            other.count = 0;
+        }
+        return *this;
+    }
+
+    ~InlineWeights() = default;
+
+    bool insert(W w) {
+        if (contains(w)) {
+            return false;
+        }
+        if (spill) {
+            spill->push_back(w);
+        }
+        else if (count < INLINE_CAPACITY) {
+            local[count] = w;
+        }
+        else {
+            spill.reset(new std::vector<W>(local, local + count));
+            spill->push_back(w);
+        }
+        count++;
+        return true;
+    }
+
+    bool contains(W w) const {
+        return std::find(begin(), end(), w) != end();
+    }
+
+    bool erase(W w) {
+        W* first = spill ? spill->data() : local;
+        W* last = first + count;
+        W* it = std::find(first, last, w);
+        if (it == last) {
+            return false;
+        }
+        *it = *(last - 1);
+        if (spill) {
+            spill->pop_back();
+        }
+        count--;
+        return true;
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    W front() const { return *begin(); }
+    W min() const { return *std::min_element(begin(), end()); }
+
+    const W* begin() const { return spill ? spill->data() : local; }
+    const W* end() const { return begin() + count; }
+};
+
+#endif
@@ -2,7 +2,11 @@
 #define ARBORESCENCE_H
 
 #include "../graph/edge.h"
+#include "../graph/CowVector.h"
+#include "../graph/EdgeList.h"
 #include "../graph/Graph.h"
+#include "../util/RadixSort.h"
+#include "../util/ThreadPool.h"
 #include <iostream>
 #include <vector>
 #include <unordered_map>
@@ -13,6 +17,9 @@
 #include <limits>
 #include <cmath>
 #include <climits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
 
 struct DirectedEdge {
     int source;         // Vértice de origem 
@@ -31,8 +38,34 @@ class DirectedGraph {
 private:
     int max_vertices;                                           // Capacidade máxima 
     int current_vertices;                                       // |V| atual
-    std::vector<std::unordered_map<int, double>> outgoing;     // [u][v] = peso da aresta u→v
-    std::vector<std::unordered_map<int, double>> incoming;     // [v][u] = peso da aresta u→v
+    int edge_total;                                             // |E|, mantido a cada alteração
+    // Cópias do grafo compartilham os blocos de mapas (e a forma compacta inteira);
+    // cada cópia só duplica o que alterar
+    CowVector<std::unordered_map<int, double>> outgoing;     // [u][v] = peso da aresta u→v
+    CowVector<std::unordered_map<int, double>> incoming;     // [v][u] = peso da aresta u→v
+
+    // Forma compacta: saída em CSR e entrada em CSC, linhas ordenadas pelo vizinho, ids de 32 bits.
+    // A CSC guarda a origem e a posição da aresta na CSR (permutação compartilhada), então o
+    // custo existe uma vez só: 20 bytes por aresta com custos double e 16 com float, contra
+    // ~100 dos dois mapas. Os mapas ficam vazios enquanto ela estiver ativa
+    struct CompactStorage {
+        std::vector<uint32_t> out_offset;       // Saídas de u: [out_offset[u], out_offset[u + 1])
+        std::vector<uint32_t> out_target;
+        std::vector<double> out_cost;           // Vazio com custos float
+        std::vector<float> out_cost_float;
+        std::vector<uint32_t> in_offset;        // Entradas de v: [in_offset[v], in_offset[v + 1])
+        std::vector<uint32_t> in_source;
+        std::vector<uint32_t> in_edge;          // Posição na CSR da aresta de entrada
+
+        double cost(uint32_t e) const {
+            return out_cost.empty() ? out_cost_float[e] : out_cost[e];
+        }
+    };
+    bool compact_mode;
+    std::shared_ptr<CompactStorage> packed;                 // Compartilhada entre cópias
+
+    void build_compact(const std::vector<uint32_t>& source, const std::vector<uint32_t>& target,
+                       const std::vector<double>& cost, ThreadPool& pool, bool float_costs);
 
 public:
     DirectedGraph(int capacity);
@@ -49,18 +82,66 @@ public:
     bool disconnect(int from, int to);                     // Remove conexão 
     bool has_connection(int from, int to) const;           // Verifica se existe conexão
     double connection_cost(int from, int to) const;       // Obtém custo da conexão 
-    int total_connections() const;                         // |E|
+    int total_connections() const;                         // |E|, O(1)
+    int out_degree(int vertex) const;
+    int in_degree(int vertex) const;
+
+    // Forma compacta (CSR + CSC); connect/disconnect depois disso voltam para os mapas
+    void compact(ThreadPool& pool = ThreadPool::shared(), bool float_costs = false);
+    void expand();                      // Volta para os mapas, O(m); connect/disconnect fazem isso na primeira alteração
+    bool is_compact() const;
     
     // Navegação dentro do grafo por arestas
     std::unordered_map<int, double> get_destinations_from(int vertex) const;   // Para onde o vértice aponta
     std::unordered_map<int, double> get_sources_to(int vertex) const;          // Quem aponta para o vértice
+    template <typename Fn> void for_each_destination(int vertex, Fn fn) const;  // fn(v, custo) sem copiar a linha
+    template <typename Fn> void for_each_source(int vertex, Fn fn) const;       // fn(u, custo); na forma compacta, em ordem de u
     std::vector<DirectedEdge> get_all_connections() const;                     // Todas as arestas do grafo
-    std::vector<DirectedEdge> get_minimum_undirected_edges() const;             // Pares u-v com menor custo
+    std::vector<DirectedEdge> get_all_connections(ThreadPool& pool) const;     // Mesma ordem, linhas copiadas em paralelo
+    std::vector<DirectedEdge> get_minimum_undirected_edges(ThreadPool& pool = ThreadPool::shared()) const;  // Pares u-v (u < v) com menor custo, ordenados por (u, v)
+    EdgeList<double> edge_list(ThreadPool& pool = ThreadPool::shared()) const;                  // get_all_connections em arrays separados
+    EdgeList<double> minimum_undirected_edge_list(ThreadPool& pool = ThreadPool::shared()) const;  // get_minimum_undirected_edges em arrays separados
     
     void display() const;                                                 
     bool is_reachable(int from, int to) const;                               // Verifica se o destino é alcancável a partir da origem
     
-    static DirectedGraph from_weighted_graph(const WeightedGraph& weighted_graph);  // Converte WeightedGraph direcionado em DirectedGraph
+    // As cargas em lote já saem na forma compacta
+    template <typename W, template <typename> class Multiplicity>
+    static DirectedGraph from_weighted_graph(const BasicWeightedGraph<W, Multiplicity>& weighted_graph);  // Converte WeightedGraph direcionado em DirectedGraph
+
+    // Formato binário (ver GraphFile.h)
+    bool save_binary(const std::string& path) const;                                               // Grava as arestas de saída em CSR
+    static MappedGraph open_mapped(const std::string& path, bool verify_checksums = false);        // Abre o arquivo com mmap, sem cópia
+    static DirectedGraph from_mapped(const MappedGraph& mapped);                                   // Reconstrói o grafo a partir do arquivo
+    static DirectedGraph from_csr(const graph_file::Csr& csr, ThreadPool& pool = ThreadPool::shared());  // Carga em lote (ver Generators.h)
+    static DirectedGraph from_edges(int n, const std::vector<DirectedEdge>& edges, ThreadPool& pool);    // Como connect() na ordem da lista (pares repetidos: vale o último)
+};
+
+
+// Índice de uma arborescência (ou floresta), montado uma vez em O(n)
+// Raízes da floresta: vértices sem pai válido, com pai igual a si mesmo (segment_image)
+// e a própria root_vertex. Vértices presos em ciclos ficam fora do índice (pre = -1)
+struct ArborescenceIndex {
+    std::vector<int> child_offset;      // Filhos de v: child_list[child_offset[v] .. child_offset[v + 1]) (CSR)
+    std::vector<int> child_list;        // Em ordem crescente, inclui v quando parent_of[v] == v
+    std::vector<int> pre;               // Numeração em pré-ordem (-1 fora do índice)
+    std::vector<int> post;              // Numeração em pós-ordem
+    std::vector<int> order;             // Vértices em pré-ordem: a subárvore de v é order[pre[v] .. pre[v] + subtree_size[v])
+    std::vector<int> depth;             // Distância até root_vertex (-1 se não chega nela)
+    std::vector<int> subtree_size;      // Vértices na subárvore, incluindo v (0 fora do índice)
+
+    static ArborescenceIndex build(const std::vector<int>& parent_of, int root_vertex);
+};
+
+
+// Variáveis duais do LP de Edmonds, para certificar minimalidade (ver verifier.h)
+// Família laminar de conjuntos de vértices sem a raiz, como floresta de nós:
+// nós 0..n-1 são os vértices, nós n.. são ciclos contraídos; cluster_parent[x] > x (-1 no topo)
+struct ArborescenceDuals {
+    std::vector<int> cluster_parent;
+    std::vector<double> value;          // y de cada nó; >= 0 fora dos unitários, 0 na raiz
+
+    bool empty() const { return value.empty(); }
 };
 
 
@@ -70,20 +151,40 @@ struct ArborescenceResult {
     double total_tree_cost;             // Custo total de toda a arborescência
     int root_vertex;                    // Raiz?
     bool is_complete;                   
+    ArborescenceDuals duals;            // Só quando o algoritmo é chamado com with_duals
     
     ArborescenceResult(int num_vertices, int root);
     
     void display_tree() const;                        
     std::vector<int> get_children_of(int vertex) const;    // Retorna filhos diretos de um vértice
     int get_tree_depth_of(int vertex) const;              // Calcula profundidade 
-    bool is_ancestor(int possible_ancestor, int descendant) const;  // Relação ancestral
+    bool is_ancestor(int possible_ancestor, int descendant) const;  // Relação ancestral, O(1)
+    int get_subtree_size_of(int vertex) const;            // Vértices na subárvore de vertex
+    std::vector<int> get_descendants_of(int vertex) const;  // Subárvore de vertex em pré-ordem
     
     std::vector<std::vector<int>> get_subtrees() const;
     std::vector<int> get_path_to_root(int vertex) const;
+
+    // Montado na primeira consulta; chame invalidate_index() depois de alterar parent_of.
+    // Não é thread-safe: chame index() antes de consultar de várias threads
+    const ArborescenceIndex& index() const;
+    void invalidate_index();
     
     // Converte arborescência para matriz de imagem PPM
     std::vector<std::vector<std::vector<int>>> to_ppm_matrix(
         int width, int height, const std::vector<RGB>& original_colors) const;
+
+private:
+    // Cópias não levam o índice junto, porque parent_of da cópia pode mudar
+    struct IndexCache {
+        std::shared_ptr<const ArborescenceIndex> index;
+        IndexCache() = default;
+        IndexCache(const IndexCache&) {}
+        IndexCache(IndexCache&& other) noexcept : index(std::move(other.index)) {}
+        IndexCache& operator= (const IndexCache&) { index.reset(); return *this; }
+        IndexCache& operator= (IndexCache&& other) noexcept { index = std::move(other.index); return *this; }
+    };
+    mutable IndexCache cache;
 };
 
 // DirectedEdge
@@ -100,17 +201,28 @@ inline bool DirectedEdge::is_valid() const {
 
 // DirectedGraph
 inline DirectedGraph::DirectedGraph(int capacity) 
-    : max_vertices(capacity), current_vertices(0), outgoing(capacity), incoming(capacity) {}
+    : max_vertices(capacity), current_vertices(0), edge_total(0), outgoing(capacity), incoming(capacity),
+      compact_mode(false) {}
 
 inline bool DirectedGraph::add_vertex() {
     if (current_vertices < max_vertices) {
         current_vertices++;
+        if (compact_mode) {
+            if (packed.use_count() > 1) {
+                packed = std::make_shared<CompactStorage>(*packed);
+            }
+            packed->out_offset.push_back(packed->out_offset.back());
+            packed->in_offset.push_back(packed->in_offset.back());
+        }
         return true;
     }
     return false;
 }
 
 inline void DirectedGraph::add_all_vertices() {
+    while (compact_mode && current_vertices < max_vertices) {
+        add_vertex();
+    }
     current_vertices = max_vertices;
 }
 
@@ -122,12 +234,108 @@ inline int DirectedGraph::capacity() const {
     return max_vertices;
 }
 
+inline void DirectedGraph::expand() {
+    if (!compact_mode) {
+        return;
+    }
+    for (int u = 0; u < current_vertices; u++) {
+        for (uint32_t e = packed->out_offset[u]; e < packed->out_offset[u + 1]; e++) {
+            outgoing.edit(u)[packed->out_target[e]] = packed->cost(e);
+            incoming.edit(packed->out_target[e])[u] = packed->cost(e);
+        }
+    }
+    packed.reset();
+    compact_mode = false;
+}
+
+inline void DirectedGraph::build_compact(const std::vector<uint32_t>& source, const std::vector<uint32_t>& target,
+                                         const std::vector<double>& cost, ThreadPool& pool, bool float_costs) {
+    if (source.size() > static_cast<size_t>(INT_MAX)) {
+        throw std::length_error("Too many edges for DirectedGraph");
+    }
+    int n = current_vertices;
+    int m = source.size();
+
+    // Ordem estável por (origem, destino): entre pares repetidos vale o último, como em connect()
+    std::vector<uint32_t> order(m);
+    std::iota(order.begin(), order.end(), 0u);
+    radix_sort::sort(order, [&](uint32_t i) { return (static_cast<uint64_t>(source[i]) << 32) | target[i]; }, pool);
+
+    CompactStorage storage;
+    storage.out_offset.assign(n + 1, 0);
+    storage.in_offset.assign(n + 1, 0);
+    storage.out_target.reserve(m);
+    (float_costs ? storage.out_cost_float.reserve(m) : storage.out_cost.reserve(m));
+    for (int k = 0; k < m; k++) {
+        uint32_t i = order[k];
+        if (k + 1 < m && source[order[k + 1]] == source[i] && target[order[k + 1]] == target[i]) continue;
+        storage.out_offset[source[i] + 1]++;
+        storage.in_offset[target[i] + 1]++;
+        storage.out_target.push_back(target[i]);
+        if (float_costs) storage.out_cost_float.push_back(static_cast<float>(cost[i]));
+        else storage.out_cost.push_back(cost[i]);
+    }
+    std::vector<uint32_t>().swap(order);
+    for (int v = 0; v < n; v++) {
+        storage.out_offset[v + 1] += storage.out_offset[v];
+        storage.in_offset[v + 1] += storage.in_offset[v];
+    }
+
+    // CSC: a CSR já está em ordem de origem, então ordenar as posições pelo destino
+    // (estável) deixa cada coluna em ordem de origem
+    int kept = storage.out_target.size();
+    storage.in_edge.resize(kept);
+    std::iota(storage.in_edge.begin(), storage.in_edge.end(), 0u);
+    radix_sort::sort(storage.in_edge, [&](uint32_t e) { return static_cast<uint64_t>(storage.out_target[e]); }, pool);
+    std::vector<uint32_t> row_of(kept);
+    pool.parallel_for(0, n, [&](int lo, int hi) {
+        for (int u = lo; u < hi; u++) {
+            std::fill(row_of.begin() + storage.out_offset[u], row_of.begin() + storage.out_offset[u + 1], u);
+        }
+    }, 1024);
+    storage.in_source.resize(kept);
+    pool.parallel_for(0, kept, [&](int lo, int hi) {
+        for (int j = lo; j < hi; j++) {
+            storage.in_source[j] = row_of[storage.in_edge[j]];
+        }
+    });
+
+    packed = std::make_shared<CompactStorage>(std::move(storage));
+    edge_total = kept;
+    compact_mode = true;
+    outgoing = CowVector<std::unordered_map<int, double>>(max_vertices);
+    incoming = CowVector<std::unordered_map<int, double>>(max_vertices);
+}
+
+inline void DirectedGraph::compact(ThreadPool& pool, bool float_costs) {
+    std::vector<uint32_t> source, target;
+    std::vector<double> cost;
+    source.reserve(edge_total);
+    target.reserve(edge_total);
+    cost.reserve(edge_total);
+    for (int u = 0; u < current_vertices; u++) {
+        for_each_destination(u, [&](int v, double c) {
+            source.push_back(u);
+            target.push_back(v);
+            cost.push_back(c);
+        });
+    }
+    build_compact(source, target, cost, pool, float_costs);
+}
+
+inline bool DirectedGraph::is_compact() const {
+    return compact_mode;
+}
+
 inline bool DirectedGraph::connect(int from, int to, double cost) {
     if (from >= current_vertices || to >= current_vertices || from < 0 || to < 0) {
         return false;
     }
-    outgoing[from][to] = cost;
-    incoming[to][from] = cost;
+    expand();
+    if (outgoing.edit(from).insert_or_assign(to, cost).second) {
+        edge_total++;
+    }
+    incoming.edit(to)[from] = cost;
     return true;
 }
 
@@ -135,8 +343,12 @@ inline bool DirectedGraph::disconnect(int from, int to) {
     if (from >= current_vertices || to >= current_vertices || from < 0 || to < 0) {
         return false;
     }
-    outgoing[from].erase(to);
-    incoming[to].erase(from);
+    expand();
+    if (outgoing[from].count(to)) {
+        outgoing.edit(from).erase(to);
+        incoming.edit(to).erase(from);
+        edge_total--;
+    }
     return true;
 }
 
@@ -144,6 +356,11 @@ inline bool DirectedGraph::has_connection(int from, int to) const {
     if (from >= current_vertices || to >= current_vertices || from < 0 || to < 0) {
         return false;
     }
+    if (compact_mode) {
+        auto first = packed->out_target.begin() + packed->out_offset[from];
+        auto last = packed->out_target.begin() + packed->out_offset[from + 1];
+        return std::binary_search(first, last, static_cast<uint32_t>(to));
+    }
     return outgoing[from].find(to) != outgoing[from].end();
 }
 
@@ -151,74 +368,212 @@ inline double DirectedGraph::connection_cost(int from, int to) const {
     if (!has_connection(from, to)) {
         return std::numeric_limits<double>::infinity();
     }
+    if (compact_mode) {
+        auto first = packed->out_target.begin() + packed->out_offset[from];
+        auto last = packed->out_target.begin() + packed->out_offset[from + 1];
+        return packed->cost(std::lower_bound(first, last, static_cast<uint32_t>(to)) - packed->out_target.begin());
+    }
     return outgoing[from].at(to);
 }
 
 inline int DirectedGraph::total_connections() const {
-    int count = 0;
-    for (int u = 0; u < current_vertices; u++) {
-        count += outgoing[u].size();
+    return edge_total;
+}
+
+inline int DirectedGraph::out_degree(int vertex) const {
+    if (vertex >= current_vertices || vertex < 0) {
+        return 0;
     }
-    return count;
+    return compact_mode ? packed->out_offset[vertex + 1] - packed->out_offset[vertex] : outgoing[vertex].size();
 }
 
-inline std::unordered_map<int, double> DirectedGraph::get_destinations_from(int vertex) const {
+inline int DirectedGraph::in_degree(int vertex) const {
     if (vertex >= current_vertices || vertex < 0) {
-        return {};
+        return 0;
     }
-    return outgoing[vertex];
+    return compact_mode ? packed->in_offset[vertex + 1] - packed->in_offset[vertex] : incoming[vertex].size();
 }
 
-inline std::unordered_map<int, double> DirectedGraph::get_sources_to(int vertex) const {
+template <typename Fn>
+inline void DirectedGraph::for_each_destination(int vertex, Fn fn) const {
+    if (vertex >= current_vertices || vertex < 0) {
+        return;
+    }
+    if (compact_mode) {
+        for (uint32_t e = packed->out_offset[vertex]; e < packed->out_offset[vertex + 1]; e++) {
+            fn(static_cast<int>(packed->out_target[e]), packed->cost(e));
+        }
+        return;
+    }
+    for (const auto& [v, cost] : outgoing[vertex]) {
+        fn(v, cost);
+    }
+}
+
+template <typename Fn>
+inline void DirectedGraph::for_each_source(int vertex, Fn fn) const {
     if (vertex >= current_vertices || vertex < 0) {
-        return {};
+        return;
+    }
+    if (compact_mode) {
+        for (uint32_t j = packed->in_offset[vertex]; j < packed->in_offset[vertex + 1]; j++) {
+            fn(static_cast<int>(packed->in_source[j]), packed->cost(packed->in_edge[j]));
+        }
+        return;
+    }
+    for (const auto& [u, cost] : incoming[vertex]) {
+        fn(u, cost);
     }
-    return incoming[vertex];
+}
+
+inline std::unordered_map<int, double> DirectedGraph::get_destinations_from(int vertex) const {
+    if (!compact_mode) {
+        return (vertex >= current_vertices || vertex < 0) ? std::unordered_map<int, double>() : outgoing[vertex];
+    }
+    std::unordered_map<int, double> row;
+    for_each_destination(vertex, [&](int v, double cost) { row[v] = cost; });
+    return row;
+}
+
+inline std::unordered_map<int, double> DirectedGraph::get_sources_to(int vertex) const {
+    if (!compact_mode) {
+        return (vertex >= current_vertices || vertex < 0) ? std::unordered_map<int, double>() : incoming[vertex];
+    }
+    std::unordered_map<int, double> row;
+    for_each_source(vertex, [&](int u, double cost) { row[u] = cost; });
+    return row;
 }
 
 inline std::vector<DirectedEdge> DirectedGraph::get_all_connections() const {
     std::vector<DirectedEdge> edges;
+    edges.reserve(edge_total);
     for (int u = 0; u < current_vertices; u++) {
-        for (const auto& [v, cost] : outgoing[u]) {
-            edges.emplace_back(u, v, cost);
-        }
+        for_each_destination(u, [&](int v, double cost) { edges.emplace_back(u, v, cost); });
     }
     return edges;
 }
 
-inline std::vector<DirectedEdge> DirectedGraph::get_minimum_undirected_edges() const {
-    std::vector<DirectedEdge> undirected_edges;
-
-    std::unordered_map<long long, double> min_cost;
-    min_cost.reserve(total_connections());
-
-    auto encode_pair = [](int a, int b) -> long long {
-        if (a > b) {
-            std::swap(a, b);
+inline std::vector<DirectedEdge> DirectedGraph::get_all_connections(ThreadPool& pool) const {
+    std::vector<int> start(current_vertices + 1, 0);
+    for (int u = 0; u < current_vertices; u++) {
+        start[u + 1] = start[u] + out_degree(u);
+    }
+    std::vector<DirectedEdge> edges(start[current_vertices]);
+    pool.parallel_for(0, current_vertices, [&](int lo, int hi) {
+        for (int u = lo; u < hi; u++) {
+            int at = start[u];
+            for_each_destination(u, [&](int v, double cost) { edges[at++] = DirectedEdge(u, v, cost); });
         }
-        return (static_cast<long long>(a) << 32) | static_cast<unsigned int>(b);
-    };
+    }, 256);
+    return edges;
+}
 
+inline EdgeList<double> DirectedGraph::edge_list(ThreadPool& pool) const {
+    std::vector<int> start(current_vertices + 1, 0);
     for (int u = 0; u < current_vertices; u++) {
-        for (const auto& [v, cost] : outgoing[u]) {
-            if (u == v) {
-                continue;
+        start[u + 1] = start[u] + out_degree(u);
+    }
+    EdgeList<double> edges;
+    edges.resize(start[current_vertices]);
+    pool.parallel_for(0, current_vertices, [&](int lo, int hi) {
+        if (compact_mode) {
+            // Destinos copiados direto da CSR; só os custos float precisam de conversão
+            std::copy(packed->out_target.begin() + start[lo], packed->out_target.begin() + start[hi], edges.v.begin() + start[lo]);
+            for (int e = start[lo]; e < start[hi]; e++) {
+                edges.w[e] = packed->cost(e);
             }
-            long long key = encode_pair(u, v);
-            auto it = min_cost.find(key);
-            if (it == min_cost.end() || cost < it->second) {
-                min_cost[key] = cost;
+            for (int u = lo; u < hi; u++) {
+                std::fill(edges.u.begin() + start[u], edges.u.begin() + start[u + 1], u);
             }
+            return;
         }
-    }
+        for (int u = lo; u < hi; u++) {
+            int at = start[u];
+            for (const auto& [v, cost] : outgoing[u]) {
+                edges.u[at] = u;
+                edges.v[at] = v;
+                edges.w[at++] = cost;
+            }
+        }
+    }, 256);
+    return edges;
+}
+
+inline std::vector<DirectedEdge> DirectedGraph::get_minimum_undirected_edges(ThreadPool& pool) const {
+    EdgeList<double> list = minimum_undirected_edge_list(pool);
+    std::vector<DirectedEdge> undirected_edges(list.size());
+    pool.parallel_for(0, static_cast<int>(list.size()), [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++) {
+            undirected_edges[i] = DirectedEdge(list.u[i], list.v[i], list.w[i]);
+        }
+    });
+    return undirected_edges;
+}
+
+inline EdgeList<double> DirectedGraph::minimum_undirected_edge_list(ThreadPool& pool) const {
+    // Cada par sai da linha do menor vértice: u -> v pela saída de u, v -> u pela entrada de u.
+    // Sem tabela global, então as linhas são independentes e podem ser feitas em paralelo
+    auto for_each_pair = [&](int u, auto&& emit) {
+        if (compact_mode) {
+            // Saída e entrada de u já ordenadas pelo vizinho: intercalação, sai em ordem
+            uint32_t i = packed->out_offset[u], i_end = packed->out_offset[u + 1];
+            uint32_t j = packed->in_offset[u], j_end = packed->in_offset[u + 1];
+            while (i < i_end && (int)packed->out_target[i] <= u) i++;
+            while (j < j_end && (int)packed->in_source[j] <= u) j++;
+            while (i < i_end || j < j_end) {
+                uint32_t out_v = i < i_end ? packed->out_target[i] : UINT32_MAX;
+                uint32_t in_v = j < j_end ? packed->in_source[j] : UINT32_MAX;
+                if (out_v < in_v) {
+                    emit(out_v, packed->cost(i++));
+                } else if (in_v < out_v) {
+                    emit(in_v, packed->cost(packed->in_edge[j++]));
+                } else {
+                    emit(out_v, std::min(packed->cost(i++), packed->cost(packed->in_edge[j++])));
+                }
+            }
+            return;
+        }
+        for (const auto& [v, cost] : outgoing[u]) {
+            if (v <= u) continue;
+            auto back = incoming[u].find(v);
+            emit(v, back == incoming[u].end() ? cost : std::min(cost, back->second));
+        }
+        for (const auto& [v, cost] : incoming[u]) {
+            if (v <= u || outgoing[u].count(v)) continue;
+            emit(v, cost);
+        }
+    };
 
-    undirected_edges.reserve(min_cost.size());
-    for (const auto& entry : min_cost) {
-        int u = static_cast<int>(entry.first >> 32);
-        int v = static_cast<int>(entry.first & 0xffffffffLL);
-        undirected_edges.emplace_back(u, v, entry.second);
+    int n = current_vertices;
+    std::vector<int> offset(n + 1, 0);
+    pool.parallel_for(0, n, [&](int lo, int hi) {
+        for (int u = lo; u < hi; u++) {
+            for_each_pair(u, [&](int, double) { offset[u + 1]++; });
+        }
+    });
+    for (int u = 0; u < n; u++) {
+        offset[u + 1] += offset[u];
     }
 
+    EdgeList<double> undirected_edges;
+    undirected_edges.resize(offset[n]);
+    pool.parallel_for(0, n, [&](int lo, int hi) {
+        std::vector<std::pair<uint32_t, double>> row;
+        for (int u = lo; u < hi; u++) {
+            row.clear();
+            for_each_pair(u, [&](int v, double cost) { row.emplace_back(v, cost); });
+            // Ordem do hash não vaza para fora: linha ordenada por destino
+            if (!compact_mode) {
+                std::sort(row.begin(), row.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            }
+            int next = offset[u];
+            for (const auto& [v, cost] : row) {
+                undirected_edges.u[next] = u;
+                undirected_edges.v[next] = v;
+                undirected_edges.w[next++] = cost;
+            }
+        }
+    });
     return undirected_edges;
 }
 
@@ -239,32 +594,113 @@ inline bool DirectedGraph::is_reachable(int from, int to) const {
         int current = queue.front();
         queue.pop();
         
-        for (const auto& [neighbor, cost] : outgoing[current]) {
-            if (neighbor == to) return true;
+        bool found = false;
+        for_each_destination(current, [&](int neighbor, double) {
+            if (neighbor == to) found = true;
             if (!visited[neighbor]) {
                 visited[neighbor] = true;
                 queue.push(neighbor);
             }
-        }
+        });
+        if (found) return true;
     }
     return false;
 }
 
-inline DirectedGraph DirectedGraph::from_weighted_graph(const WeightedGraph& weighted_graph) {
-    WeightedGraph& graph_ref = const_cast<WeightedGraph&>(weighted_graph);
+template <typename W, template <typename> class Multiplicity>
+inline DirectedGraph DirectedGraph::from_weighted_graph(const BasicWeightedGraph<W, Multiplicity>& weighted_graph) {
+    auto& graph_ref = const_cast<BasicWeightedGraph<W, Multiplicity>&>(weighted_graph);
     int n = graph_ref.vert_count();
     DirectedGraph directed(n);
     directed.add_all_vertices();
     
+    std::vector<uint32_t> source, target;
+    std::vector<double> cost;
     for (int u = 0; u < n; u++) {
         auto neighbors = graph_ref.vert_neighbors(u);
         for (const auto& [v, weights] : neighbors) {
             if (!weights.empty()) {
-                double cost = *std::min_element(weights.begin(), weights.end());
-                directed.connect(u, v, cost);
+                source.push_back(u);
+                target.push_back(v);
+                cost.push_back(weights.min());
             }
         }
     }
+    directed.build_compact(source, target, cost, ThreadPool::shared(), false);
+    return directed;
+}
+
+inline bool DirectedGraph::save_binary(const std::string& path) const {
+    graph_file::Csr csr;
+    csr.directed = true;
+    csr.offsets.reserve(current_vertices + 1);
+    csr.offsets.push_back(0);
+    std::vector<std::pair<int, double>> row;
+    for (int u = 0; u < current_vertices; u++) {
+        // Vizinhos ordenados para que o arquivo não dependa da ordem do hash
+        row.clear();
+        for_each_destination(u, [&](int v, double cost) { row.emplace_back(v, cost); });
+        std::sort(row.begin(), row.end());
+        for (const auto& [v, cost] : row) {
+            csr.targets.push_back(static_cast<uint32_t>(v));
+            csr.weights.push_back(cost);
+        }
+        csr.offsets.push_back(csr.targets.size());
+    }
+    return graph_file::write(path, csr, false);
+}
+
+inline MappedGraph DirectedGraph::open_mapped(const std::string& path, bool verify_checksums) {
+    return MappedGraph(path, verify_checksums);
+}
+
+inline DirectedGraph DirectedGraph::from_mapped(const MappedGraph& mapped) {
+    int n = mapped.vert_count();
+    DirectedGraph directed(n);
+    directed.add_all_vertices();
+    std::vector<uint32_t> source, target;
+    std::vector<double> cost;
+    source.reserve(mapped.edge_count());
+    target.reserve(mapped.edge_count());
+    cost.reserve(mapped.edge_count());
+    for (int u = 0; u < n; u++) {
+        mapped.for_each_edge(u, [&](int v, double c) {
+            source.push_back(u);
+            target.push_back(v);
+            cost.push_back(c);
+        });
+    }
+    directed.build_compact(source, target, cost, ThreadPool::shared(), false);
+    return directed;
+}
+
+inline DirectedGraph DirectedGraph::from_csr(const graph_file::Csr& csr, ThreadPool& pool) {
+    int n = static_cast<int>(csr.offsets.size()) - 1;
+    DirectedGraph directed(n);
+    directed.add_all_vertices();
+    std::vector<uint32_t> source(csr.targets.size());
+    pool.parallel_for(0, n, [&](int lo, int hi) {
+        for (int u = lo; u < hi; u++) {
+            std::fill(source.begin() + csr.offsets[u], source.begin() + csr.offsets[u + 1], u);
+        }
+    }, 1024);
+    directed.build_compact(source, csr.targets, csr.weights, pool, false);
+    return directed;
+}
+
+inline DirectedGraph DirectedGraph::from_edges(int n, const std::vector<DirectedEdge>& edges, ThreadPool& pool) {
+    DirectedGraph directed(n);
+    directed.add_all_vertices();
+    std::vector<uint32_t> source, target;
+    std::vector<double> cost;
+    for (const DirectedEdge& e : edges) {
+        if (e.source >= 0 && e.source < n && e.target >= 0 && e.target < n) {
+            source.push_back(e.source);
+            target.push_back(e.target);
+            cost.push_back(e.cost);
+        }
+    }
+    directed.build_compact(source, target, cost, pool, false);
     return directed;
 }
 
@@ -275,45 +711,136 @@ inline ArborescenceResult::ArborescenceResult(int num_vertices, int root)
 
 inline void ArborescenceResult::display_tree() const {}
 
+inline ArborescenceIndex ArborescenceIndex::build(const std::vector<int>& parent_of, int root_vertex) {
+    int n = parent_of.size();
+    ArborescenceIndex idx;
+    auto has_parent = [&](int v) {
+        return parent_of[v] >= 0 && parent_of[v] < n;
+    };
+
+    // Filhos por contagem: cada lista sai em ordem crescente
+    idx.child_offset.assign(n + 1, 0);
+    for (int v = 0; v < n; v++) {
+        if (has_parent(v)) idx.child_offset[parent_of[v] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        idx.child_offset[v + 1] += idx.child_offset[v];
+    }
+    idx.child_list.resize(idx.child_offset[n]);
+    std::vector<int> next(idx.child_offset.begin(), idx.child_offset.end() - 1);
+    for (int v = 0; v < n; v++) {
+        if (has_parent(v)) idx.child_list[next[parent_of[v]]++] = v;
+    }
+
+    // Euler tour iterativo a partir de cada raiz da floresta
+    idx.pre.assign(n, -1);
+    idx.post.assign(n, -1);
+    idx.depth.assign(n, -1);
+    idx.subtree_size.assign(n, 0);
+    idx.order.reserve(n);
+    std::vector<int> level(n, 0);
+    std::vector<int> cursor(n, 0);
+    std::vector<int> stack;
+    int post_counter = 0;
+    for (int r = 0; r < n; r++) {
+        bool is_root = !has_parent(r) || parent_of[r] == r || r == root_vertex;
+        if (!is_root) continue;
+        bool reaches_root = r == root_vertex;
+
+        idx.pre[r] = idx.order.size();
+        idx.order.push_back(r);
+        cursor[r] = idx.child_offset[r];
+        stack.push_back(r);
+        while (!stack.empty()) {
+            int u = stack.back();
+            if (cursor[u] < idx.child_offset[u + 1]) {
+                int c = idx.child_list[cursor[u]++];
+                // Laço próprio, ciclo de volta à raiz e o pai de root_vertex não são arestas da árvore
+                if (idx.pre[c] != -1 || c == root_vertex) continue;
+                idx.pre[c] = idx.order.size();
+                idx.order.push_back(c);
+                level[c] = level[u] + 1;
+                cursor[c] = idx.child_offset[c];
+                stack.push_back(c);
+            }
+            else {
+                stack.pop_back();
+                idx.post[u] = post_counter++;
+                idx.subtree_size[u] = idx.order.size() - idx.pre[u];
+                if (reaches_root) idx.depth[u] = level[u];
+            }
+        }
+    }
+    return idx;
+}
+
+inline const ArborescenceIndex& ArborescenceResult::index() const {
+    if (!cache.index || cache.index->pre.size() != parent_of.size()) {
+        cache.index = std::make_shared<const ArborescenceIndex>(ArborescenceIndex::build(parent_of, root_vertex));
+    }
+    return *cache.index;
+}
+
+inline void ArborescenceResult::invalidate_index() {
+    cache.index.reset();
+}
+
 inline std::vector<int> ArborescenceResult::get_children_of(int vertex) const {
-    std::vector<int> children;
-    for (int v = 0; v < (int)parent_of.size(); v++) {
-        if (parent_of[v] == vertex) {
-            children.push_back(v);
+    if (vertex < 0 || vertex >= (int)parent_of.size()) {
+        // Fora do índice (ex.: -1 lista os vértices sem pai)
+        std::vector<int> children;
+        for (int v = 0; v < (int)parent_of.size(); v++) {
+            if (parent_of[v] == vertex) children.push_back(v);
         }
+        return children;
     }
-    return children;
+    const ArborescenceIndex& idx = index();
+    return std::vector<int>(idx.child_list.begin() + idx.child_offset[vertex],
+                            idx.child_list.begin() + idx.child_offset[vertex + 1]);
 }
 
 inline int ArborescenceResult::get_tree_depth_of(int vertex) const {
     if (vertex == root_vertex) return 0;
     if (vertex < 0 || vertex >= (int)parent_of.size()) return -1;
-    if (parent_of[vertex] == -1) return -1;
-    
-    int depth = 0;
-    int current = vertex;
-    
-    while (current != root_vertex && parent_of[current] != -1) {
-        current = parent_of[current];
-        depth++;
-        if (depth > (int)parent_of.size()) return -1;
-    }
-    return (current == root_vertex) ? depth : -1;
+    return index().depth[vertex];
 }
 
 inline bool ArborescenceResult::is_ancestor(int possible_ancestor, int descendant) const {
     if (possible_ancestor == descendant) return true;
-    if (descendant < 0 || descendant >= (int)parent_of.size()) return false;
-    
+    int n = parent_of.size();
+    if (descendant < 0 || descendant >= n) return false;
+    if (possible_ancestor < 0 || possible_ancestor >= n) return false;
+
+    const ArborescenceIndex& idx = index();
+    if (idx.pre[descendant] != -1) {
+        return idx.pre[possible_ancestor] != -1 &&
+               idx.pre[possible_ancestor] <= idx.pre[descendant] &&
+               idx.post[descendant] <= idx.post[possible_ancestor];
+    }
+    // Fora do índice (ciclo): sobe pelos pais, no máximo n passos
     int current = descendant;
-    while (current != -1 && current != root_vertex) {
+    for (int steps = 0; steps < n && current >= 0 && current < n && current != root_vertex; steps++) {
         if (parent_of[current] == possible_ancestor) return true;
         current = parent_of[current];
     }
     return false;
 }
 
+inline int ArborescenceResult::get_subtree_size_of(int vertex) const {
+    if (vertex < 0 || vertex >= (int)parent_of.size()) return 0;
+    return index().subtree_size[vertex];
+}
+
+inline std::vector<int> ArborescenceResult::get_descendants_of(int vertex) const {
+    if (vertex < 0 || vertex >= (int)parent_of.size()) return {};
+    const ArborescenceIndex& idx = index();
+    if (idx.pre[vertex] == -1) return {};
+    return std::vector<int>(idx.order.begin() + idx.pre[vertex],
+                            idx.order.begin() + idx.pre[vertex] + idx.subtree_size[vertex]);
+}
+
 inline std::vector<std::vector<int>> ArborescenceResult::get_subtrees() const {
+    const ArborescenceIndex& idx = index();
     std::vector<std::vector<int>> subtrees;
     std::vector<bool> visited(parent_of.size(), false);
     
@@ -331,8 +858,8 @@ inline std::vector<std::vector<int>> ArborescenceResult::get_subtrees() const {
                     visited[current] = true;
                     subtree.push_back(current);
                     
-                    auto children = get_children_of(current);
-                    for (int child : children) {
+                    for (int i = idx.child_offset[current]; i < idx.child_offset[current + 1]; i++) {
+                        int child = idx.child_list[i];
                         if (!visited[child]) {
                             stack.push(child);
                         }
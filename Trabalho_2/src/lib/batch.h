@@ -0,0 +1,159 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "../util/Ppm.h"
+#include "../graph/PixelMetric.h"
+#include "../graph/edge.h"
+#include "unionfind.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Per-image segmentation for batch runs
+// Same stages as main (grayscale, blur, Sobel, color+gradient weights, Felzenszwalb),
+// but every buffer lives in a workspace that is reused from one image to the next
+
+struct SegmentationParams {
+    int gray_blur_passes = 5;
+    int color_blur_passes = 3;
+    double color_scale = 1.1;
+    double gradient_scale = 0.45;
+    double k = 300.0;
+};
+
+enum BatchStage {
+    STAGE_LOAD,
+    STAGE_PREPROCESS,   // Grayscale + blur of both images
+    STAGE_SOBEL,
+    STAGE_GRAPH,        // Grid edges with color+gradient weights
+    STAGE_SORT,
+    STAGE_SEGMENT,      // Union-find sweep
+    STAGE_WRITE,        // Average colors + PPM output
+    STAGE_COUNT
+};
+
+inline const char* stage_name(int stage) {
+    static const char* names[STAGE_COUNT] = {
+        "load", "preprocess", "sobel", "graph", "sort", "segment", "write"
+    };
+    return names[stage];
+}
+
+struct SegmentationWorkspace {
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<std::vector<int>>> image;
+    std::vector<std::vector<std::vector<int>>> gray;
+    std::vector<std::vector<std::vector<int>>> gray_blurred;
+    std::vector<std::vector<std::vector<int>>> color_blurred;
+    std::vector<std::vector<std::vector<int>>> sobel;
+    std::vector<std::vector<std::vector<int>>> scratch;
+    FeaturePlanes features;         // Blurred color + gradient magnitude per pixel
+    std::vector<Edge> edges;        // Grid graph of the current image
+    SegmentUnionFind uf;
+    std::vector<long long> color_sum;
+    std::vector<int> segment_size;
+
+    double stage_seconds[STAGE_COUNT] = {};
+    int segment_count = 0;
+};
+
+// Grayscale copy of ws.image, then both blurs
+inline void preprocess_image(SegmentationWorkspace &ws, const SegmentationParams &params) {
+    int width = ws.width, height = ws.height;
+    reshapeImage(ws.gray, width, height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            ws.gray[y][x] = ws.image[y][x];
+        }
+    }
+    grayscaleImg(ws.gray, width, height);
+    blurImg(ws.gray, width, height, params.gray_blur_passes, ws.gray_blurred, ws.scratch);
+    blurImg(ws.image, width, height, params.color_blur_passes, ws.color_blurred, ws.scratch);
+}
+
+// Paints ws.image with the average original color of each ws.uf segment
+inline void paint_segments(SegmentationWorkspace &ws) {
+    int width = ws.width, n = ws.width * ws.height;
+    ws.color_sum.assign(3 * n, 0);
+    ws.segment_size.assign(n, 0);
+    ws.segment_count = 0;
+    for (int i = 0; i < n; i++) {
+        int root = ws.uf.find(i);
+        const std::vector<int> &pixel = ws.image[i / width][i % width];
+        if (ws.segment_size[root]++ == 0) ws.segment_count++;
+        ws.color_sum[3 * root] += pixel[0];
+        ws.color_sum[3 * root + 1] += pixel[1];
+        ws.color_sum[3 * root + 2] += pixel[2];
+    }
+    for (int i = 0; i < n; i++) {
+        int root = ws.uf.find(i);
+        std::vector<int> &pixel = ws.image[i / width][i % width];
+        for (int c = 0; c < 3; c++) {
+            pixel[c] = ws.color_sum[3 * root + c] / ws.segment_size[root];
+        }
+    }
+}
+
+// Segments input_path into output_path; false when the image cannot be read
+inline bool segment_file(
+    const std::string &input_path, const std::string &output_path,
+    const SegmentationParams &params, SegmentationWorkspace &ws
+) {
+    using clock = std::chrono::steady_clock;
+    auto mark = clock::now();
+    auto lap = [&](int stage) {
+        auto now = clock::now();
+        ws.stage_seconds[stage] = std::chrono::duration<double>(now - mark).count();
+        mark = now;
+    };
+
+    if (!loadPPM(input_path, ws.image, ws.width, ws.height)) {
+        return false;
+    }
+    int width = ws.width, height = ws.height, n = width * height;
+    lap(STAGE_LOAD);
+
+    preprocess_image(ws, params);
+    lap(STAGE_PREPROCESS);
+
+    sobelOperator(ws.gray_blurred, width, height, ws.sobel);
+    lap(STAGE_SOBEL);
+
+    // Same 4 forward neighbours and weights as WeightedGraph::from_color_and_gradient
+    ws.features.assign(ws.color_blurred, ws.sobel, width, height);
+    ws.edges.clear();
+    pixel_metric::GradientBlended<> metric{params.color_scale, params.gradient_scale};
+    auto add = [&](int i, int other) {
+        ws.edges.emplace_back(i, other, ws.features.weight(i, other, metric));
+    };
+    for (int i = 0; i < n; i++) {
+        int x = i % width, y = i / width;
+        if (x > 0 && y < height - 1) add(i, i + width - 1);
+        if (y < height - 1) add(i, i + width);
+        if (x < width - 1 && y < height - 1) add(i, i + width + 1);
+        if (x < width - 1) add(i, i + 1);
+    }
+    lap(STAGE_GRAPH);
+
+    std::sort(ws.edges.begin(), ws.edges.end(), [](const Edge &a, const Edge &b) {
+        return a.w < b.w;
+    });
+    lap(STAGE_SORT);
+
+    ws.uf.reset(n);
+    for (const Edge &e : ws.edges) {
+        ws.uf.join(e.u, e.v, e.w, params.k);
+    }
+    lap(STAGE_SEGMENT);
+
+    // Average original color per segment, written over the loaded image
+    paint_segments(ws);
+    savePPM_matrix(output_path, ws.image, width, height);
+    lap(STAGE_WRITE);
+
+    return true;
+}
+
+#endif
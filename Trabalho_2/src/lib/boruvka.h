@@ -0,0 +1,228 @@
+#ifndef BORUVKA_H
+#define BORUVKA_H
+
+#include "../graph/Graph.h"
+#include "../graph/edge.h"
+#include "../util/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+// Minimum spanning forest by Borůvka's algorithm, each round in parallel
+//
+// Every round, each component picks its lightest incident edge (lock-free CAS on
+// the edge id), components hook along those edges (the mutual pair of a
+// 2-cycle is broken by id), labels are resolved by pointer jumping and edges
+// now inside a component are filtered out. Ties are broken by edge position,
+// so the forest is the same one Kruskal finds with a stable sort.
+//
+// The forest comes back sorted by (weight, position), the order in which
+// SegmentationHierarchy sweeps it with the Felzenszwalb criterion.
+class BoruvkaMST {
+
+private:
+
+    static bool lighter(const std::vector<Edge>& edges, int a, int b) {
+        return edges[a].w < edges[b].w || (edges[a].w == edges[b].w && a < b);
+    }
+
+    static void offer(std::atomic<int>& slot, int e, const std::vector<Edge>& edges) {
+        int current = slot.load(std::memory_order_relaxed);
+        while ((current == -1 || lighter(edges, e, current)) &&
+               !slot.compare_exchange_weak(current, e, std::memory_order_relaxed)) {}
+    }
+
+    // Items of `items` for which keep(item) holds, in order, into `out`
+    template <typename Keep>
+    static void compact(const std::vector<int>& items, std::vector<int>& out, Keep keep, ThreadPool& pool) {
+        int total = items.size();
+        int chunk = std::max(4096, (total + pool.size() * 4 - 1) / (pool.size() * 4));
+        int chunk_count = (total + chunk - 1) / chunk;
+        std::vector<int> offset(chunk_count + 1, 0);
+        pool.parallel_for(0, chunk_count, [&](int lo, int hi) {
+            for (int c = lo; c < hi; c++) {
+                int end = std::min(total, (c + 1) * chunk);
+                for (int i = c * chunk; i < end; i++) {
+                    if (keep(items[i])) offset[c + 1]++;
+                }
+            }
+        }, 1);
+        for (int c = 0; c < chunk_count; c++) {
+            offset[c + 1] += offset[c];
+        }
+        out.resize(offset[chunk_count]);
+        pool.parallel_for(0, chunk_count, [&](int lo, int hi) {
+            for (int c = lo; c < hi; c++) {
+                int next = offset[c];
+                int end = std::min(total, (c + 1) * chunk);
+                for (int i = c * chunk; i < end; i++) {
+                    if (keep(items[i])) out[next++] = items[i];
+                }
+            }
+        }, 1);
+    }
+
+public:
+
+    // Undirected edges (each pair once); self-loops are ignored
+    static std::vector<Edge> spanning_forest(int n, const std::vector<Edge>& edges, ThreadPool& pool = ThreadPool::shared()) {
+        std::vector<int> comp(n);
+        std::iota(comp.begin(), comp.end(), 0);
+        std::vector<int> hook(n);
+        std::vector<int> root(n);
+        std::vector<int> jumped(n);
+        std::vector<std::atomic<int>> best(n);
+
+        std::vector<int> all(edges.size());
+        std::iota(all.begin(), all.end(), 0);
+        std::vector<int> active;
+        compact(all, active, [&](int e) { return edges[e].u != edges[e].v; }, pool);
+        std::vector<int> next_active;
+
+        std::vector<int> forest_ids(std::max(0, n - 1));
+        std::atomic<int> forest_size{0};
+
+        while (!active.empty()) {
+            pool.parallel_for(0, n, [&](int lo, int hi) {
+                for (int c = lo; c < hi; c++) {
+                    best[c].store(-1, std::memory_order_relaxed);
+                }
+            });
+
+            // Lightest edge leaving each component
+            pool.parallel_for(0, (int)active.size(), [&](int lo, int hi) {
+                for (int i = lo; i < hi; i++) {
+                    int e = active[i];
+                    offer(best[comp[edges[e].u]], e, edges);
+                    offer(best[comp[edges[e].v]], e, edges);
+                }
+            });
+
+            // Hook each component to the one across its edge; in a mutual pair the smaller id stays root
+            int before = forest_size.load();
+            pool.parallel_for(0, n, [&](int lo, int hi) {
+                for (int c = lo; c < hi; c++) {
+                    hook[c] = c;
+                    if (comp[c] != c) continue;
+                    int e = best[c].load(std::memory_order_relaxed);
+                    if (e == -1) continue;
+                    int other = comp[edges[e].u] == c ? comp[edges[e].v] : comp[edges[e].u];
+                    if (best[other].load(std::memory_order_relaxed) == e && c < other) continue;
+                    hook[c] = other;
+                    forest_ids[forest_size.fetch_add(1, std::memory_order_relaxed)] = e;
+                }
+            });
+            if (forest_size.load() == before) {
+                break;
+            }
+
+            // Pointer jumping: hook chains only go through component ids and end at a root.
+            // Each pass points every component at its target's target, so a chain of
+            // length L is resolved in log L passes of O(n)
+            pool.parallel_for(0, n, [&](int lo, int hi) {
+                for (int c = lo; c < hi; c++) {
+                    if (comp[c] == c) root[c] = hook[c];
+                }
+            });
+            std::atomic<bool> moved{true};
+            while (moved.load()) {
+                moved.store(false);
+                pool.parallel_for(0, n, [&](int lo, int hi) {
+                    bool any = false;
+                    for (int c = lo; c < hi; c++) {
+                        if (comp[c] != c) continue;
+                        jumped[c] = root[root[c]];
+                        any |= jumped[c] != root[c];
+                    }
+                    if (any) moved.store(true, std::memory_order_relaxed);
+                });
+                root.swap(jumped);
+            }
+            pool.parallel_for(0, n, [&](int lo, int hi) {
+                for (int v = lo; v < hi; v++) {
+                    comp[v] = root[comp[v]];
+                }
+            });
+
+            compact(active, next_active, [&](int e) { return comp[edges[e].u] != comp[edges[e].v]; }, pool);
+            active.swap(next_active);
+        }
+
+        forest_ids.resize(forest_size.load());
+        std::sort(forest_ids.begin(), forest_ids.end(), [&](int a, int b) { return lighter(edges, a, b); });
+        std::vector<Edge> forest;
+        forest.reserve(forest_ids.size());
+        for (int e : forest_ids) {
+            forest.push_back(edges[e]);
+        }
+        return forest;
+    }
+
+    // Smallest weight of every neighbour pair (u < v) of the graph, rows in ascending v
+    template <typename W, template <typename> class Multiplicity>
+    static std::vector<Edge> spanning_forest(const BasicWeightedGraph<W, Multiplicity>& graph, ThreadPool& pool = ThreadPool::shared()) {
+        int n = graph.vert_count();
+        std::vector<int> offset(n + 1, 0);
+        pool.parallel_for(0, n, [&](int lo, int hi) {
+            for (int u = lo; u < hi; u++) {
+                graph.for_each_neighbor(u, [&](int v) {
+                    if (v > u) offset[u + 1]++;
+                });
+            }
+        });
+        for (int u = 0; u < n; u++) {
+            offset[u + 1] += offset[u];
+        }
+        std::vector<Edge> edges(offset[n]);
+        pool.parallel_for(0, n, [&](int lo, int hi) {
+            for (int u = lo; u < hi; u++) {
+                int next = offset[u];
+                graph.for_each_neighbor(u, [&](int v) {
+                    if (v <= u) return;
+                    double lightest = std::numeric_limits<double>::infinity();
+                    graph.for_each_weight(u, v, [&](W w) {
+                        lightest = std::min(lightest, static_cast<double>(w));
+                    });
+                    edges[next++] = Edge(u, v, lightest);
+                });
+                // Row order as in the graph file (ascending v), not hash order, so ties go
+                // the same way for both
+                std::sort(edges.begin() + offset[u], edges.begin() + next, [](const Edge& a, const Edge& b) {
+                    return a.v < b.v;
+                });
+            }
+        });
+        return spanning_forest(n, edges, pool);
+    }
+
+    // Same for a mapped graph file written by save_binary: every entry u -> v with u < v
+    // (one per pair there, and rows are already sorted)
+    static std::vector<Edge> spanning_forest(const MappedGraph& graph, ThreadPool& pool = ThreadPool::shared()) {
+        int n = graph.vert_count();
+        std::vector<int> offset(n + 1, 0);
+        pool.parallel_for(0, n, [&](int lo, int hi) {
+            for (int u = lo; u < hi; u++) {
+                graph.for_each_neighbor(u, [&](int v) {
+                    if (v > u) offset[u + 1]++;
+                });
+            }
+        });
+        for (int u = 0; u < n; u++) {
+            offset[u + 1] += offset[u];
+        }
+        std::vector<Edge> edges(offset[n]);
+        pool.parallel_for(0, n, [&](int lo, int hi) {
+            for (int u = lo; u < hi; u++) {
+                int next = offset[u];
+                graph.for_each_edge(u, [&](int v, double w) {
+                    if (v > u) edges[next++] = Edge(u, v, w);
+                });
+            }
+        });
+        return spanning_forest(n, edges, pool);
+    }
+};
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef MINIMUM_BRANCHING_H
+#define MINIMUM_BRANCHING_H
+
+#include "arborescence.h"
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <vector>
+
+// Ramificação mínima (floresta) como arborescência com raiz virtual
+//
+// Cada vértice v ganha uma aresta raiz -> v com o custo de "começar um segmento" em v;
+// a arborescência mínima a partir da raiz virtual, sem essas arestas, é a floresta
+// de custo mínimo, e cada filho da raiz vira um segmento.
+//
+// Chu-Liu/Edmonds com contração em O(m log n) (Tarjan; Camerini et al. para recuperar
+// a árvore): as arestas de entrada de cada componente ficam num heap esquerdista com
+// desconto preguiçoso, ciclos são fundidos num union-find com desfazer e a árvore é
+// reconstruída desfazendo as contrações na ordem inversa. O mesmo motor serve para
+// arborescências com raiz fixa (find_arborescence), opcionalmente com o certificado dual.
+class MinimumBranching {
+private:
+
+    static constexpr double INF = std::numeric_limits<double>::infinity();
+
+    struct Arc {
+        int source;
+        int target;
+        double cost;
+    };
+
+    // Heap esquerdista de arestas; delta é somado a toda a subárvore (desconto preguiçoso)
+    struct HeapNode {
+        int arc;
+        double key;
+        double delta;
+        int left;
+        int right;
+        int rank;
+    };
+
+    std::vector<Arc> arcs;
+    std::vector<HeapNode> nodes;
+    std::vector<int> uf_parent;
+    std::vector<int> uf_size;
+    std::vector<std::pair<int, int>> uf_history;   // (filho, raiz) de cada união, para desfazer
+
+    void push_down(int h) {
+        HeapNode& node = nodes[h];
+        if (node.delta == 0.0) return;
+        node.key += node.delta;
+        if (node.left != -1) nodes[node.left].delta += node.delta;
+        if (node.right != -1) nodes[node.right].delta += node.delta;
+        node.delta = 0.0;
+    }
+
+    int merge(int a, int b) {
+        if (a == -1) return b;
+        if (b == -1) return a;
+        push_down(a);
+        push_down(b);
+        if (nodes[b].key < nodes[a].key) std::swap(a, b);
+        nodes[a].right = merge(nodes[a].right, b);
+        int left = nodes[a].left, right = nodes[a].right;
+        if (left == -1 || nodes[left].rank < nodes[right].rank) {
+            std::swap(nodes[a].left, nodes[a].right);
+        }
+        nodes[a].rank = nodes[a].right == -1 ? 0 : nodes[nodes[a].right].rank + 1;
+        return a;
+    }
+
+    int find(int x) const {
+        while (uf_parent[x] != x) x = uf_parent[x];
+        return x;
+    }
+
+    // União por tamanho, sem compressão de caminho (para poder desfazer)
+    bool join(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (uf_size[a] < uf_size[b]) std::swap(a, b);
+        uf_parent[b] = a;
+        uf_size[a] += uf_size[b];
+        uf_history.emplace_back(b, a);
+        return true;
+    }
+
+    void rollback(int time) {
+        while ((int)uf_history.size() > time) {
+            auto [child, root] = uf_history.back();
+            uf_history.pop_back();
+            uf_parent[child] = child;
+            uf_size[root] -= uf_size[child];
+        }
+    }
+
+    // Arborescência mínima de `arcs` sobre vertices vértices a partir de root; incoming[v] = arco escolhido.
+    // duals: y de cada componente é a soma dos custos reduzidos escolhidos por ela
+    bool solve(int vertices, int root, std::vector<int>& incoming, ArborescenceDuals* duals) {
+        int n = vertices;
+        std::vector<int> heap(n, -1);
+        nodes.clear();
+        nodes.reserve(arcs.size());
+        for (int i = 0; i < (int)arcs.size(); i++) {
+            nodes.push_back(HeapNode{i, arcs[i].cost, 0.0, -1, -1, 0});
+            heap[arcs[i].target] = merge(heap[arcs[i].target], i);
+        }
+
+        uf_parent.resize(n);
+        for (int v = 0; v < n; v++) uf_parent[v] = v;
+        uf_size.assign(n, 1);
+        uf_history.clear();
+
+        std::vector<int> node_of;               // Nó dual de cada componente (pela raiz do union-find)
+        if (duals) {
+            duals->cluster_parent.assign(n, -1);
+            duals->value.assign(n, 0.0);
+            node_of.resize(n);
+            for (int v = 0; v < n; v++) node_of[v] = v;
+        }
+
+        std::vector<int> seen(n, -1);
+        std::vector<int> path(n);
+        std::vector<int> chosen(n);             // Aresta escolhida em cada passo do caminho
+        incoming.assign(n, -1);                 // Aresta que entra em cada componente
+        struct Contraction {
+            int component;
+            int time;
+            std::vector<int> cycle_arcs;
+        };
+        std::deque<Contraction> contractions;
+        seen[root] = root;
+
+        for (int start = 0; start < n; start++) {
+            int u = start, steps = 0;
+            while (seen[u] < 0) {
+                if (heap[u] == -1) {
+                    return false;       // Sem aresta de entrada: não há arborescência
+                }
+                push_down(heap[u]);
+                int top = heap[u];
+                double cost = nodes[top].key;
+                // Desconta o custo escolhido de todas as arestas que entram na componente
+                heap[u] = merge(nodes[top].left, nodes[top].right);
+                if (heap[u] != -1) nodes[heap[u]].delta -= cost;
+                if (duals) duals->value[node_of[u]] += cost;
+
+                chosen[steps] = nodes[top].arc;
+                path[steps++] = u;
+                seen[u] = start;
+                u = find(arcs[nodes[top].arc].source);
+                if (seen[u] == start) {
+                    // Ciclo: funde as componentes do caminho até u
+                    int cycle_heap = -1, end = steps, time = uf_history.size(), w;
+                    std::vector<int> members;
+                    do {
+                        w = path[--steps];
+                        members.push_back(w);
+                        cycle_heap = merge(cycle_heap, heap[w]);
+                    } while (join(u, w));
+                    u = find(u);
+                    heap[u] = cycle_heap;
+                    seen[u] = -1;
+                    contractions.push_front(Contraction{u, time, std::vector<int>(chosen.begin() + steps, chosen.begin() + end)});
+                    // Laço de uma componente só (aresta interna) não cria conjunto novo
+                    if (duals && members.size() > 1) {
+                        int node = duals->value.size();
+                        duals->value.push_back(0.0);
+                        duals->cluster_parent.push_back(-1);
+                        for (int m : members) duals->cluster_parent[node_of[m]] = node;
+                        node_of[u] = node;
+                    }
+                }
+            }
+            for (int i = 0; i < steps; i++) {
+                incoming[find(arcs[chosen[i]].target)] = chosen[i];
+            }
+        }
+
+        // Desfaz as contrações da última para a primeira: a aresta que entra no ciclo
+        // substitui a do ciclo que chegava no mesmo vértice
+        for (const Contraction& c : contractions) {
+            rollback(c.time);
+            int entering = incoming[c.component];
+            for (int a : c.cycle_arcs) {
+                incoming[find(arcs[a].target)] = a;
+            }
+            incoming[find(arcs[entering].target)] = entering;
+        }
+        return true;
+    }
+
+    // Arborescência de `arcs` já montados, no formato de find_arborescence
+    ArborescenceResult arborescence_of_arcs(int n, int root_vertex, bool with_duals) {
+        ArborescenceResult result(n, root_vertex);
+        std::vector<int> incoming;
+        ArborescenceDuals duals;
+        if (!solve(n, root_vertex, incoming, with_duals ? &duals : nullptr)) {
+            return result;
+        }
+        result.total_tree_cost = 0.0;
+        for (int v = 0; v < n; v++) {
+            if (v == root_vertex) continue;
+            result.parent_of[v] = arcs[incoming[v]].source;
+            result.edge_costs[v] = arcs[incoming[v]].cost;
+            result.total_tree_cost += arcs[incoming[v]].cost;
+        }
+        result.duals = std::move(duals);
+        result.is_complete = true;
+        return result;
+    }
+
+public:
+
+    // Mesmo formato de EdmondsAlgorithm::find_minimum_cost_arborescence (with_duals preenche result.duals)
+    ArborescenceResult find_arborescence(const DirectedGraph& graph, int root_vertex, bool with_duals = false) {
+        int n = graph.vertex_count();
+        if (root_vertex < 0 || root_vertex >= n) {
+            return ArborescenceResult(n, root_vertex);
+        }
+        arcs.clear();
+        arcs.reserve(graph.total_connections());
+        for (int u = 0; u < n; u++) {
+            graph.for_each_destination(u, [&](int v, double cost) {
+                if (u != v && v != root_vertex) arcs.push_back(Arc{u, v, cost});
+            });
+        }
+        return arborescence_of_arcs(n, root_vertex, with_duals);
+    }
+
+    // O mesmo sobre uma lista de arestas entre os vértices 0..vertices-1, sem montar um DirectedGraph
+    ArborescenceResult find_arborescence(int vertices, const std::vector<DirectedEdge>& edges, int root_vertex, bool with_duals = false) {
+        if (root_vertex < 0 || root_vertex >= vertices) {
+            return ArborescenceResult(vertices, root_vertex);
+        }
+        arcs.clear();
+        arcs.reserve(edges.size());
+        for (const DirectedEdge& edge : edges) {
+            if (edge.source != edge.target && edge.target != root_vertex) arcs.push_back(Arc{edge.source, edge.target, edge.cost});
+        }
+        return arborescence_of_arcs(vertices, root_vertex, with_duals);
+    }
+
+    // new_segment_cost[v]: custo da aresta raiz virtual -> v (INF = v não pode começar segmento)
+    // parent_of[v] = -1 nos vértices que começam um segmento; root_vertex = -1
+    ArborescenceResult find_branching(const DirectedGraph& graph, const std::vector<double>& new_segment_cost) {
+        int n = graph.vertex_count();
+        int root = n;
+        ArborescenceResult result(n, -1);
+
+        arcs.clear();
+        arcs.reserve(graph.total_connections() + n);
+        for (int u = 0; u < n; u++) {
+            graph.for_each_destination(u, [&](int v, double cost) {
+                if (u != v) arcs.push_back(Arc{u, v, cost});
+            });
+        }
+        for (int v = 0; v < n; v++) {
+            if (new_segment_cost[v] < INF) arcs.push_back(Arc{root, v, new_segment_cost[v]});
+        }
+        std::vector<int> incoming;
+        if (!solve(n + 1, root, incoming, nullptr)) {
+            return result;
+        }
+
+        result.total_tree_cost = 0.0;
+        for (int v = 0; v < n; v++) {
+            const Arc& arc = arcs[incoming[v]];
+            result.parent_of[v] = arc.source == root ? -1 : arc.source;
+            result.edge_costs[v] = arc.cost;
+            result.total_tree_cost += arc.cost;
+        }
+        result.is_complete = true;
+        return result;
+    }
+
+    ArborescenceResult find_branching(const DirectedGraph& graph, double new_segment_cost) {
+        return find_branching(graph, std::vector<double>(graph.vertex_count(), new_segment_cost));
+    }
+
+    // Rótulos no formato de EdmondsAlgorithm::segment_image (parent_of = raiz do segmento)
+    static ArborescenceResult to_segments(const ArborescenceResult& branching) {
+        int n = branching.parent_of.size();
+        ArborescenceResult result(n, -1);
+        result.edge_costs = branching.edge_costs;
+        result.total_tree_cost = branching.total_tree_cost;
+        result.is_complete = branching.is_complete;
+        // Pré-ordem: o pai já tem rótulo quando o filho aparece
+        for (int v : branching.index().order) {
+            int parent = branching.parent_of[v];
+            result.parent_of[v] = parent == -1 ? v : result.parent_of[parent];
+        }
+        return result;
+    }
+
+    ArborescenceResult segment_image(const DirectedGraph& graph, double new_segment_cost) {
+        return to_segments(find_branching(graph, new_segment_cost));
+    }
+};
+
+#endif
@@ -0,0 +1,521 @@
+#ifndef DYNAMIC_ARBORESCENCE_H
+#define DYNAMIC_ARBORESCENCE_H
+
+#include "arborescence.h"
+#include "branching.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+// Arborescência mínima mantida sob lotes de inserções, remoções e mudanças de custo
+//
+// Guarda a árvore junto com o certificado dual de Edmonds (ver verifier.h). Cada
+// atualização só olha a aresta alterada: o custo reduzido c - y(conjuntos em que
+// ela entra) sai subindo a floresta laminar a partir das duas pontas, O(profundidade).
+// - aresta fora da árvore removida, ou com custo reduzido >= 0: a árvore continua mínima;
+// - aresta da árvore mais barata: o y do vértice de destino desce junto, continua mínima;
+// - aresta da árvore mais cara: o y do destino sobe junto se as outras arestas que
+//   entram nele têm folga suficiente, O(grau de entrada);
+// - aresta da árvore removida ou cara demais, aresta nova com custo reduzido negativo:
+//   se o destino v não está em nenhum ciclo contraído, só {v} recebe essas arestas, então
+//   v passa a ter como pai a aresta de entrada mais barata que não venha de um descendente
+//   (y_v = esse custo), O(grau de entrada + profundidade na árvore);
+//   se v está num ciclo contraído X, refaz só X (resolve_cluster): Edmonds em X com uma
+//   raiz virtual no lugar do resto, mantendo os duais de fora. Se a árvore nova não fecha
+//   com eles, tenta conjuntos maiores que contêm v, dobrando de tamanho, O(m_X log n) cada;
+// - qualquer outro caso, ou X com mais da metade dos vértices: recalcula tudo com o
+//   motor O(m log n) de MinimumBranching, uma vez por lote.
+// O grafo passa para os mapas na construção, então cada alteração custa O(1).
+// A árvore é a mesma de um recálculo quando o mínimo é único (com empates, é uma das
+// mínimas, certificada pelos duais).
+class DynamicArborescence {
+
+public:
+
+    struct EdgeUpdate {
+        int source;
+        int target;
+        double cost;        // Ignorado em remoções
+        bool remove;
+
+        static EdgeUpdate set(int from, int to, double cost) { return EdgeUpdate{from, to, cost, false}; }
+        static EdgeUpdate erase(int from, int to) { return EdgeUpdate{from, to, 0.0, true}; }
+    };
+
+private:
+
+    static constexpr double TOLERANCE = 1e-9;
+
+    DirectedGraph graph;
+    int root;
+    ArborescenceResult tree;
+    std::vector<int> cluster_depth;
+    std::vector<double> prefix;         // Soma de y de cada nó até o topo
+    // Vértices de cada nó da floresta laminar lado a lado: members[span_begin[x] .. + span_size[x])
+    std::vector<int> members;
+    std::vector<int> position;          // Posição de cada vértice em members
+    std::vector<int> span_begin;
+    std::vector<int> span_size;
+    std::vector<int> fill;              // Cursor de lay_out
+    std::vector<char> released;         // Marca de resolve_cluster
+    bool recomputed = true;
+    int checked_edges = 0;
+
+    void recompute() {
+        MinimumBranching engine;
+        tree = engine.find_arborescence(graph, root, true);
+        recomputed = true;
+        index_clusters();
+    }
+
+    void index_clusters() {
+        int nodes = tree.duals.value.size();
+        cluster_depth.assign(nodes, 0);
+        prefix.assign(nodes, 0.0);
+        span_begin.assign(nodes, 0);
+        span_size.assign(nodes, 0);
+        fill.assign(nodes, 0);
+        released.assign(nodes, false);
+        members.assign(graph.vertex_count(), 0);
+        position.assign(graph.vertex_count(), 0);
+        std::vector<int> all(nodes);
+        std::iota(all.begin(), all.end(), 0);
+        lay_out(all, -1, 0);
+    }
+
+    // Refaz span, profundidade e prefix dos nós de list (filhos antes dos pais);
+    // os que têm pai `above` (-1: o topo) ficam lado a lado a partir de offset
+    void lay_out(const std::vector<int>& list, int above, int offset) {
+        const std::vector<int>& parent = tree.duals.cluster_parent;
+        const std::vector<double>& value = tree.duals.value;
+        int n = graph.vertex_count();
+        for (int x : list) span_size[x] = x < n ? 1 : 0;
+        for (int x : list) {
+            if (parent[x] != above) span_size[parent[x]] += span_size[x];
+        }
+        int next = offset;
+        for (auto it = list.rbegin(); it != list.rend(); ++it) {
+            int x = *it, p = parent[x];
+            if (p == above) {
+                span_begin[x] = next;
+                next += span_size[x];
+            } else {
+                span_begin[x] = fill[p];
+                fill[p] += span_size[x];
+            }
+            cluster_depth[x] = p == -1 ? 0 : cluster_depth[p] + 1;
+            prefix[x] = value[x] + (p == -1 ? 0.0 : prefix[p]);
+            fill[x] = span_begin[x];
+            if (x < n) {
+                members[span_begin[x]] = x;
+                position[x] = span_begin[x];
+            }
+        }
+    }
+
+    // Novos ids para os ciclos (mais fundos primeiro, então o pai fica com id maior), sem os vazios
+    void renumber_clusters() {
+        std::vector<int>& parent = tree.duals.cluster_parent;
+        std::vector<double>& value = tree.duals.value;
+        int n = graph.vertex_count(), nodes = parent.size();
+        std::vector<int> depth(nodes, -1), children(nodes, 0), path;
+        for (int x = 0; x < nodes; x++) {
+            if (parent[x] != -1) children[parent[x]]++;
+            int y = x;
+            while (depth[y] == -1 && parent[y] != -1) {
+                path.push_back(y);
+                y = parent[y];
+            }
+            if (depth[y] == -1) depth[y] = 0;
+            for (int d = depth[y]; !path.empty(); path.pop_back()) depth[path.back()] = ++d;
+        }
+        std::vector<int> kept;
+        for (int x = n; x < nodes; x++) {
+            if (children[x] > 0) kept.push_back(x);
+        }
+        std::stable_sort(kept.begin(), kept.end(), [&](int a, int b) { return depth[a] > depth[b]; });
+        std::vector<int> id(nodes, -1);
+        std::iota(id.begin(), id.begin() + n, 0);
+        for (int i = 0; i < (int)kept.size(); i++) id[kept[i]] = n + i;
+        ArborescenceDuals renumbered;
+        renumbered.cluster_parent.assign(n + kept.size(), -1);
+        renumbered.value.assign(n + kept.size(), 0.0);
+        for (int x = 0; x < nodes; x++) {
+            if (id[x] == -1) continue;
+            renumbered.cluster_parent[id[x]] = parent[x] == -1 ? -1 : id[parent[x]];
+            renumbered.value[id[x]] = value[x];
+        }
+        tree.duals = std::move(renumbered);
+        index_clusters();
+    }
+
+    // Menor nó da floresta laminar com u e v (-1 se nenhum)
+    int common_cluster(int u, int v) const {
+        const std::vector<int>& parent = tree.duals.cluster_parent;
+        int a = u, b = v;
+        while (a != -1 && b != -1 && a != b) {
+            if (cluster_depth[a] >= cluster_depth[b]) a = parent[a];
+            else b = parent[b];
+        }
+        return (a == b) ? a : -1;
+    }
+
+    // Soma de y dos conjuntos que contêm v (vértice ou nó) e não u
+    double entering(int u, int v) const {
+        int lca = common_cluster(u, v);
+        return prefix[v] - (lca == -1 ? 0.0 : prefix[lca]);
+    }
+
+    // Menor custo reduzido das arestas que entram em v, fora a da árvore
+    double slack_into(int v) {
+        double slack = std::numeric_limits<double>::infinity();
+        graph.for_each_source(v, [&](int u, double cost) {
+            if (u == v || u == tree.parent_of[v]) return;
+            slack = std::min(slack, cost - entering(u, v));
+            checked_edges++;
+        });
+        return slack;
+    }
+
+    bool is_descendant(int u, int v) const {
+        for (int x = u; x != -1; x = tree.parent_of[x]) {
+            if (x == v) return true;
+        }
+        return false;
+    }
+
+    // Troca o pai de v pela aresta de entrada mais barata; só vale com v fora de ciclos contraídos
+    bool reattach(int v) {
+        if (tree.duals.cluster_parent[v] != -1) return false;
+        double cheapest = std::numeric_limits<double>::infinity();
+        graph.for_each_source(v, [&](int u, double cost) {
+            if (u != v) cheapest = std::min(cheapest, cost);
+        });
+        checked_edges += graph.in_degree(v);
+        // Qualquer aresta de custo mínimo serve, desde que não feche um ciclo
+        int best = -1;
+        graph.for_each_source(v, [&](int u, double cost) {
+            if (u != v && cost <= cheapest && (best == -1 || u < best) && !is_descendant(u, v)) best = u;
+        });
+        if (best == -1) return false;
+        tree.total_tree_cost += cheapest - tree.edge_costs[v];
+        tree.parent_of[v] = best;
+        tree.edge_costs[v] = cheapest;
+        tree.duals.value[v] = cheapest;
+        prefix[v] = cheapest;
+        tree.invalidate_index();
+        return true;
+    }
+
+    // Aresta de fora de X que a raiz virtual R representa
+    struct OutsideEdge {
+        int source = -1;
+        double cost = std::numeric_limits<double>::infinity();
+        double reduced = std::numeric_limits<double>::infinity();    // c - y dos conjuntos acima de X
+    };
+
+    // Os duais de X resolvido com parte das arestas de fora ainda valem para as outras:
+    // best[i] é a de menor custo reduzido entre todas as que chegam a i
+    static bool covers_skipped(const ArborescenceResult& local, const std::vector<OutsideEdge>& best, int size) {
+        const ArborescenceDuals& duals = local.duals;
+        std::vector<double> sum(duals.value.size(), 0.0);   // y dos conjuntos que contêm o nó
+        for (int x = (int)sum.size() - 1; x >= 0; x--) {
+            int p = duals.cluster_parent[x];
+            sum[x] = duals.value[x] + (p == -1 ? 0.0 : sum[p]);
+        }
+        for (int i = 0; i < size; i++) {
+            if (best[i].source == -1) continue;
+            if (best[i].reduced - sum[i] < -scale(best[i].reduced, sum[i])) return false;
+        }
+        return true;
+    }
+
+    // A solução local de X serve para a árvore toda: cada conjunto acima de X com y > 0
+    // continua recebendo uma aresta só, e subir das entradas novas não fecha ciclo
+    bool entries_fit(int cluster, const ArborescenceResult& local, const std::vector<OutsideEdge>& outside, int old_source) const {
+        const std::vector<int>& parent = tree.duals.cluster_parent;
+        const std::vector<double>& value = tree.duals.value;
+        int begin = span_begin[cluster], size = span_size[cluster];
+
+        // Vértices de X que a árvore nova liga a fora, e em qual deles cada vértice se pendura
+        std::vector<int> entries, entry_of(size, -1);
+        for (int i = 0; i < size; i++) {
+            if (local.parent_of[i] == size) {
+                entry_of[i] = entries.size();
+                entries.push_back(i);
+            }
+        }
+        for (int i = 0; i < size; i++) {
+            int x = i;
+            while (entry_of[x] == -1) x = local.parent_of[x];
+            for (int y = i; entry_of[y] == -1; y = local.parent_of[y]) entry_of[y] = entry_of[x];
+        }
+
+        // Uma aresta entra nos conjuntos abaixo do menor que contém sua origem
+        int k = entries.size();
+        std::vector<int> reach(k);
+        for (int j = 0; j < k; j++) reach[j] = common_cluster(outside[entries[j]].source, cluster);
+        int old_reach = common_cluster(old_source, cluster), entering_new = k;
+        bool entering_old = true;
+        for (int x = parent[cluster]; x != -1; x = parent[x]) {
+            if (x == old_reach) entering_old = false;
+            for (int j = 0; j < k; j++) entering_new -= reach[j] == x;
+            if (value[x] > TOLERANCE && entering_new != (int)entering_old) return false;
+        }
+
+        // Os pais de fora de X não mudam: subindo da origem de cada entrada chega-se à raiz
+        // ou a um vértice de X, isto é, a outra entrada, e essa cadeia não pode voltar
+        std::vector<int> next(k, -1);
+        for (int j = 0; j < k; j++) {
+            int x = outside[entries[j]].source;
+            if (x == old_source) continue;      // Já chegava à raiz sem passar por X
+            while (x != -1 && (position[x] < begin || position[x] >= begin + size)) x = tree.parent_of[x];
+            if (x != -1) next[j] = entry_of[position[x] - begin];
+        }
+        for (int j = 0; j < k; j++) {
+            int x = j;
+            for (int steps = 0; x != -1 && steps <= k; steps++) x = next[x];
+            if (x != -1) return false;
+        }
+        return true;
+    }
+
+    // Refaz só o conjunto contraído X: Edmonds em X mais uma raiz virtual R no lugar de
+    // todo o resto, com cada aresta de fora w -> x virando R -> x de custo c - (y dos
+    // conjuntos acima de X em que ela entra). Os duais de fora de X não mudam, e os de
+    // dentro saem da solução (X some como conjunto; os novos ficam sob o pai de X).
+    // Vale se cada conjunto acima de X com y > 0 continua recebendo uma aresta só da
+    // árvore e as entradas novas não fecham ciclo; senão devolve false sem mexer em nada.
+    // O(m_X log |X| + entradas * profundidade)
+    bool resolve_cluster(int cluster) {
+        std::vector<int>& parent = tree.duals.cluster_parent;
+        std::vector<double>& value = tree.duals.value;
+        int begin = span_begin[cluster], size = span_size[cluster], outside_root = size;
+        std::vector<int> vertices(members.begin() + begin, members.begin() + begin + size);    // Id local -> vértice
+        auto inside = [&](int w) { return position[w] >= begin && position[w] < begin + size; };
+
+        int old_source = -1;
+        for (int v : vertices) {
+            int p = tree.parent_of[v];
+            if (p == -1) return false;
+            if (!inside(p)) {
+                if (old_source != -1) return false;
+                old_source = p;
+            }
+        }
+        if (old_source == -1) return false;
+        // y dos conjuntos acima de X em que u -> X entra. Esses conjuntos são os de baixo da
+        // cadeia acima de X, então duas arestas com a mesma soma entram nos mesmos com y > 0
+        auto above = [&](int u) { return entering(u, cluster) - value[cluster]; };
+        double old_above = above(old_source);
+
+        // Só a aresta de fora mais barata de cada vértice conta (empate: a da árvore), entre
+        // as que entram nos mesmos conjuntos que a antiga (same) e entre todas (any)
+        std::vector<OutsideEdge> same(size), any(size);
+        std::vector<DirectedEdge> internal;
+        bool narrowed = false;
+        for (int i = 0; i < size; i++) {
+            int v = vertices[i];
+            graph.for_each_source(v, [&](int u, double cost) {
+                if (u == v) return;
+                checked_edges++;
+                if (inside(u)) {
+                    internal.emplace_back(position[u] - begin, i, cost);
+                    return;
+                }
+                double over = above(u);
+                OutsideEdge edge{u, cost, cost - over};
+                auto better = [&](const OutsideEdge& best) {
+                    return edge.reduced < best.reduced || (edge.reduced == best.reduced && u == tree.parent_of[v]);
+                };
+                if (better(any[i])) any[i] = edge;
+                if (std::abs(over - old_above) <= scale(over, old_above) && better(same[i])) same[i] = edge;
+            });
+            narrowed |= same[i].source != any[i].source;
+        }
+
+        // Resolve X com as arestas de same; com degenerescência (pesos empatados) costuma dar
+        // a mesma árvore ótima sem trocar a cadeia de cima. Se não der, tenta com todas
+        MinimumBranching engine;
+        ArborescenceResult local(0, -1);
+        const std::vector<OutsideEdge>* chosen = nullptr;
+        for (const std::vector<OutsideEdge>* candidates : {&same, &any}) {
+            std::vector<DirectedEdge> arcs(internal);
+            for (int i = 0; i < size; i++) {
+                const OutsideEdge& edge = (*candidates)[i];
+                if (edge.source != -1) arcs.emplace_back(outside_root, i, edge.reduced);
+            }
+            local = engine.find_arborescence(size + 1, arcs, outside_root, true);
+            if (local.is_complete &&
+                (candidates == &any || covers_skipped(local, any, size)) &&
+                entries_fit(cluster, local, *candidates, old_source)) {
+                chosen = candidates;
+                break;
+            }
+            if (!narrowed) break;
+        }
+        if (chosen == nullptr) return false;
+        const std::vector<OutsideEdge>& outside = *chosen;
+
+        // Os nós de X para baixo saem; os novos reaproveitam seus ids (menores que o do pai
+        // de X, em ordem) quando cabem, senão vão para o fim e tudo é renumerado
+        const ArborescenceDuals& inner = local.duals;
+        int up = parent[cluster];
+        std::vector<int> freed{cluster};
+        released[cluster] = true;
+        for (int v : vertices) {
+            for (int x = parent[v]; !released[x]; x = parent[x]) {
+                released[x] = true;
+                freed.push_back(x);
+            }
+        }
+        std::sort(freed.begin(), freed.end());
+        for (int x : freed) {
+            released[x] = false;
+            parent[x] = -1;
+            value[x] = 0.0;
+            span_size[x] = 0;
+        }
+        int created = (int)inner.value.size() - (size + 1);
+        bool renumber = created > (int)freed.size();
+        std::vector<int> id(vertices);
+        id.push_back(-1);           // R
+        for (int j = 0; j < created; j++) {
+            if (!renumber) {
+                id.push_back(freed[j]);
+                continue;
+            }
+            id.push_back(parent.size());
+            parent.push_back(-1);
+            value.push_back(0.0);
+        }
+        for (int x = 0; x < (int)inner.value.size(); x++) {
+            if (x == outside_root) continue;
+            int p = inner.cluster_parent[x];
+            parent[id[x]] = p == -1 ? up : id[p];
+            value[id[x]] = inner.value[x];
+        }
+
+        for (int i = 0; i < size; i++) {
+            int v = vertices[i];
+            bool from_outside = local.parent_of[i] == outside_root;
+            double cost = from_outside ? outside[i].cost : local.edge_costs[i];
+            tree.total_tree_cost += cost - tree.edge_costs[v];
+            tree.parent_of[v] = from_outside ? outside[i].source : vertices[local.parent_of[i]];
+            tree.edge_costs[v] = cost;
+        }
+        tree.invalidate_index();
+
+        if (renumber) {
+            renumber_clusters();
+            return true;
+        }
+        id.erase(id.begin() + outside_root);
+        lay_out(id, up, begin);
+        return true;
+    }
+
+    // Conserta a árvore depois que u -> v saiu, encareceu ou ficou com custo reduzido negativo;
+    // false quando só um recálculo resolve. Tenta os conjuntos que contêm v de baixo para
+    // cima, dobrando de tamanho a cada tentativa, então as falhas somam O(m log n) no máximo
+    bool repair_into(int v) {
+        const std::vector<int>& parent = tree.duals.cluster_parent;
+        if (parent[v] == -1) {
+            return reattach(v);
+        }
+        int n = graph.vertex_count(), tried = 0;
+        for (int cluster = parent[v]; cluster != -1; cluster = parent[cluster]) {
+            int size = span_size[cluster];
+            if (2 * size > n) {
+                return false;       // Refazer X custaria o mesmo que recalcular tudo
+            }
+            if (size < 2 * tried) {
+                continue;
+            }
+            if (resolve_cluster(cluster)) {
+                return true;
+            }
+            tried = size;
+        }
+        return false;
+    }
+
+    static double scale(double a, double b) {
+        return TOLERANCE * std::max({1.0, std::abs(a), std::abs(b)});
+    }
+
+public:
+
+    DynamicArborescence(const DirectedGraph& graph, int root_vertex)
+    : graph(graph), root(root_vertex), tree(graph.vertex_count(), root_vertex) {
+        // A conversão O(m) da forma compacta acontece aqui, junto com o cálculo inicial,
+        // e não na primeira atualização
+        this->graph.expand();
+        recompute();
+    }
+
+    // Aplica o lote ao grafo e conserta a árvore; true se precisou recalcular tudo
+    bool apply(const std::vector<EdgeUpdate>& batch) {
+        int n = graph.vertex_count();
+        bool repair = !tree.is_complete;
+        recomputed = false;
+        checked_edges = 0;
+
+        for (const EdgeUpdate& update : batch) {
+            int u = update.source, v = update.target;
+            if (u < 0 || u >= n || v < 0 || v >= n) continue;
+            bool in_tree = v != root && tree.parent_of[v] == u;
+            if (update.remove) graph.disconnect(u, v);
+            else graph.connect(u, v, update.cost);
+            if (repair || u == v || v == root) continue;
+            checked_edges++;
+
+            if (!in_tree) {
+                if (!update.remove && update.cost - entering(u, v) < -scale(update.cost, entering(u, v))) {
+                    repair = !repair_into(v);
+                }
+                continue;
+            }
+            if (update.remove) {
+                repair = !repair_into(v);
+                continue;
+            }
+            double delta = update.cost - tree.edge_costs[v];
+            if (delta > 0.0 && slack_into(v) < delta - scale(delta, update.cost)) {
+                repair = !repair_into(v);
+                continue;
+            }
+            // y do vértice v (conjunto unitário, sem filhos na floresta) acompanha a aresta
+            tree.duals.value[v] += delta;
+            prefix[v] += delta;
+            tree.edge_costs[v] = update.cost;
+            tree.total_tree_cost += delta;
+        }
+
+        if (repair) {
+            recompute();
+        }
+        return recomputed;
+    }
+
+    const ArborescenceResult& result() const {
+        return tree;
+    }
+
+    const DirectedGraph& current_graph() const {
+        return graph;
+    }
+
+    // Arestas examinadas no último lote (sem contar um recálculo)
+    int last_checked_edges() const {
+        return checked_edges;
+    }
+
+    bool last_was_recomputed() const {
+        return recomputed;
+    }
+};
+
+#endif
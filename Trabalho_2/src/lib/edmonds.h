@@ -2,7 +2,11 @@
 #define EDMONDS_H
 
 #include "arborescence.h"
+#include "unionfind.h"
+#include "../util/RadixSort.h"
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <limits>
 #include <numeric>
 #include <queue>
@@ -38,70 +42,7 @@ private:
         std::vector<std::vector<int>> cycles;
     };
     
-    struct UnionFind {
-        std::vector<int> parent;
-        std::vector<int> size;
-        std::vector<double> internal_cost; // Custo interno máximo da componente
-
-        UnionFind(int n) : parent(n), size(n, 1), internal_cost(n, 0.0) {
-            for (int i = 0; i < n; i++) {
-                parent[i] = i;
-            }
-        }
-
-        int find(int x) {
-            if (parent[x] != x) {
-                parent[x] = find(parent[x]);
-            }
-            return parent[x];
-        }
-
-        bool join(int u, int v, double edge_weight, double k) {
-            int root_u = find(u);
-            int root_v = find(v);
-
-            if (root_u == root_v) {
-                return false;
-            }
-
-            // Limiar Felzenszwalb: MInt(C1,C2) = min(Int(C1)+k/|C1|, Int(C2)+k/|C2|)
-            double threshold_u = internal_cost[root_u] + k / size[root_u];
-            double threshold_v = internal_cost[root_v] + k / size[root_v];
-            double threshold = std::min(threshold_u, threshold_v);
-
-            // Funde apenas se a diferença for pequena o suficiente
-            if (edge_weight <= threshold) {
-                // Une os conjuntos
-                if (size[root_u] < size[root_v]) {
-                    parent[root_u] = root_v;
-                    size[root_v] += size[root_u];
-                    // Distância interna é o peso da aresta de fusão
-                    internal_cost[root_v] = edge_weight;
-                } else {
-                    parent[root_v] = root_u;
-                    size[root_u] += size[root_v];
-                    internal_cost[root_u] = edge_weight;
-                }
-                return true;
-            }
-            return false;
-        }
-
-        void force_merge(int u, int v, double weight_hint) {
-            int root_u = find(u);
-            int root_v = find(v);
-            if (root_u == root_v) {
-                return;
-            }
-            if (size[root_u] < size[root_v]) {
-                std::swap(root_u, root_v);
-            }
-            parent[root_v] = root_u;
-            size[root_u] += size[root_v];
-            // Mantém o maior custo interno das duas componentes
-            internal_cost[root_u] = std::max(internal_cost[root_u], internal_cost[root_v]);
-        }
-    };
+    using UnionFind = SegmentUnionFind;
 
     struct CycleComponent {
         std::vector<int> vertices_in_cycle;
@@ -113,22 +54,34 @@ private:
             : cycle_representative(-1), cheapest_entry_cost(INFINITE_COST), cheapest_entry_source(-1) {}
     };
     
+    // Aresta contraída em modo paralelo: par (origem, destino) de componentes e a aresta original escolhida
+    struct ContractedRecord {
+        uint64_t key;
+        int best;           // Primeira ocorrência de menor custo ajustado
+    };
+
+    ThreadPool* pool;       // nullptr: todas as fases num único thread
+
     std::vector<DirectedEdge> find_cheapest_incoming_edges(const DirectedGraph& graph, int root) {
         int n = graph.vertex_count();
         std::vector<DirectedEdge> cheapest_edges(n);
         std::vector<double> min_costs(n, INFINITE_COST);
         
-        for (int v = 0; v < n; v++) {
-            if (v == root) continue;
-            
-            auto sources = graph.get_sources_to(v);
-            for (const auto& [u, cost] : sources) {
-                if (cost < min_costs[v]) {
-                    min_costs[v] = cost;
-                    cheapest_edges[v] = DirectedEdge(u, v, cost);
-                }
+        auto scan = [&](int lo, int hi) {
+            for (int v = lo; v < hi; v++) {
+                if (v == root) continue;
+
+                graph.for_each_source(v, [&](int u, double cost) {
+                    if (cost < min_costs[v]) {
+                        min_costs[v] = cost;
+                        cheapest_edges[v] = DirectedEdge(u, v, cost);
+                    }
+                });
             }
-        }
+        };
+        // Cada vértice só olha a própria linha: o resultado não depende da divisão
+        if (pool) pool->parallel_for(0, n, scan, 256);
+        else scan(0, n);
         
         return cheapest_edges;
     }
@@ -168,11 +121,173 @@ private:
         return result;
     }
 
+    // Mesmo resultado de detect_cycles (ciclos e numeração) por saltos de ponteiro, O(n log n)
+    // Após 2^K >= n saltos todo vértice cai num ciclo (ou na raiz); low guarda o menor vértice
+    // do caminho, que num ciclo é o seu rótulo. detect_cycles numera os ciclos pelo menor
+    // vértice inicial que chega a cada um e começa a lista no primeiro vértice de ciclo do caminho
+    CycleDetectionResult detect_cycles_parallel(const std::vector<DirectedEdge>& cheapest_edges,
+                                                int num_vertices,
+                                                int root) {
+        int n = num_vertices;
+        CycleDetectionResult result;
+        result.cycle_id_of_vertex.assign(n, -1);
+        auto next_of = [&](int v) { return v == root ? v : cheapest_edges[v].source; };
+
+        std::vector<int> jump(n), low(n), jump_out(n), low_out(n);
+        pool->parallel_for(0, n, [&](int lo, int hi) {
+            for (int v = lo; v < hi; v++) {
+                jump[v] = next_of(v);
+                low[v] = v;
+            }
+        });
+        for (int span = 1; span < n; span *= 2) {
+            pool->parallel_for(0, n, [&](int lo, int hi) {
+                for (int v = lo; v < hi; v++) {
+                    jump_out[v] = jump[jump[v]];
+                    low_out[v] = std::min(low[v], low[jump[v]]);
+                }
+            });
+            jump.swap(jump_out);
+            low.swap(low_out);
+        }
+
+        std::vector<std::atomic<char>> on_cycle(n);
+        std::vector<std::atomic<int>> first_start(n);
+        pool->parallel_for(0, n, [&](int lo, int hi) {
+            for (int v = lo; v < hi; v++) {
+                on_cycle[v].store(0, std::memory_order_relaxed);
+                first_start[v].store(n, std::memory_order_relaxed);
+            }
+        });
+        pool->parallel_for(0, n, [&](int lo, int hi) {
+            for (int v = lo; v < hi; v++) {
+                on_cycle[jump[v]].store(1, std::memory_order_relaxed);
+                int label = low[jump[v]];
+                if (v == root || label == root) continue;
+                int seen = first_start[label].load(std::memory_order_relaxed);
+                while (v < seen && !first_start[label].compare_exchange_weak(seen, v, std::memory_order_relaxed)) {}
+            }
+        });
+
+        // Rótulo de cada ciclo = seu menor vértice, em ordem de descoberta
+        std::vector<int> labels;
+        for (int v = 0; v < n; v++) {
+            if (v != root && on_cycle[v].load(std::memory_order_relaxed) && low[v] == v) labels.push_back(v);
+        }
+        std::sort(labels.begin(), labels.end(), [&](int a, int b) {
+            return first_start[a].load(std::memory_order_relaxed) < first_start[b].load(std::memory_order_relaxed);
+        });
+
+        // Os caminhos até ciclos diferentes são disjuntos: O(n) no total
+        result.cycles.resize(labels.size());
+        pool->parallel_for(0, static_cast<int>(labels.size()), [&](int lo, int hi) {
+            for (int c = lo; c < hi; c++) {
+                int entry = first_start[labels[c]].load(std::memory_order_relaxed);
+                while (!on_cycle[entry].load(std::memory_order_relaxed)) entry = next_of(entry);
+                int node = entry;
+                do {
+                    result.cycles[c].push_back(node);
+                    result.cycle_id_of_vertex[node] = c;
+                    node = next_of(node);
+                } while (node != entry);
+            }
+        }, 64);
+        return result;
+    }
+
+    // Contração com espalhamento paralelo; mesmo grafo e mesmas arestas escolhidas que o laço
+    // sequencial: de cada par fica a primeira de menor custo ajustado
+    DirectedGraph contract_parallel(const EdgeList<double>& all_edges,
+                                    const std::vector<int>& component_id,
+                                    const std::vector<DirectedEdge>& cheapest_edges,
+                                    const CycleDetectionResult& cycle_detection,
+                                    int contracted_vertices,
+                                    std::vector<ContractedRecord>& records) {
+        ThreadPool& p = *pool;
+        int m = all_edges.size();
+        std::vector<double> adjusted(m);
+        std::vector<uint64_t> key(m);
+        std::vector<char> crossing(m);
+        p.parallel_for(0, m, [&](int lo, int hi) {
+            for (int i = lo; i < hi; i++) {
+                int from_comp = component_id[all_edges.u[i]];
+                int to_comp = component_id[all_edges.v[i]];
+                crossing[i] = from_comp != to_comp;
+                adjusted[i] = all_edges.w[i];
+                if (cycle_detection.cycle_id_of_vertex[all_edges.v[i]] != -1) {
+                    adjusted[i] -= cheapest_edges[all_edges.v[i]].cost;
+                }
+                key[i] = (static_cast<uint64_t>(from_comp) << 32) | static_cast<uint32_t>(to_comp);
+            }
+        });
+
+        // Compacta em ordem as arestas entre componentes e agrupa por par (ordenação estável)
+        std::vector<int> candidates = compact(m, [&](int i) { return crossing[i] != 0; });
+        radix_sort::sort(candidates, [&](int i) { return key[i]; }, p);
+
+        int count = candidates.size();
+        std::vector<int> group_starts = compact(count, [&](int j) {
+            return j == 0 || key[candidates[j]] != key[candidates[j - 1]];
+        });
+        records.resize(group_starts.size());
+        p.parallel_for(0, static_cast<int>(group_starts.size()), [&](int lo, int hi) {
+            for (int g = lo; g < hi; g++) {
+                int begin = group_starts[g];
+                int end = g + 1 < (int)group_starts.size() ? group_starts[g + 1] : count;
+                int best = candidates[begin];
+                for (int j = begin + 1; j < end; j++) {
+                    if (adjusted[candidates[j]] < adjusted[best]) best = candidates[j];
+                }
+                records[g] = ContractedRecord{key[candidates[begin]], best};
+            }
+        });
+
+        std::vector<DirectedEdge> contracted_edges(records.size());
+        p.parallel_for(0, static_cast<int>(records.size()), [&](int lo, int hi) {
+            for (int i = lo; i < hi; i++) {
+                const ContractedRecord& record = records[i];
+                contracted_edges[i] = DirectedEdge(static_cast<int>(record.key >> 32),
+                                                   static_cast<int>(record.key & 0xffffffffULL),
+                                                   adjusted[record.best]);
+            }
+        });
+        return DirectedGraph::from_edges(contracted_vertices, contracted_edges, p);
+    }
+
+    // Índices i em [0, total) com keep(i), em ordem (contagem por bloco + preenchimento)
+    template <typename Keep>
+    std::vector<int> compact(int total, Keep keep) {
+        ThreadPool& p = *pool;
+        int chunk = std::max(1 << 14, (total + p.size() * 4 - 1) / (p.size() * 4));
+        int chunk_count = (total + chunk - 1) / chunk;
+        std::vector<int> offset(chunk_count + 1, 0);
+        p.parallel_for(0, chunk_count, [&](int lo, int hi) {
+            for (int c = lo; c < hi; c++) {
+                int kept = 0;
+                for (int i = c * chunk; i < std::min(total, (c + 1) * chunk); i++) kept += keep(i) ? 1 : 0;
+                offset[c + 1] = kept;
+            }
+        }, 1);
+        for (int c = 0; c < chunk_count; c++) offset[c + 1] += offset[c];
+        std::vector<int> out(offset[chunk_count]);
+        p.parallel_for(0, chunk_count, [&](int lo, int hi) {
+            for (int c = lo; c < hi; c++) {
+                int at = offset[c];
+                for (int i = c * chunk; i < std::min(total, (c + 1) * chunk); i++) {
+                    if (keep(i)) out[at++] = i;
+                }
+            }
+        }, 1);
+        return out;
+    }
+
     static long long encode_edge_key(int from, int to) {
         return (static_cast<long long>(from) << 32) ^ (static_cast<unsigned long long>(to) & 0xffffffffULL);
     }
 
-    InternalResult run_chu_liu(const DirectedGraph& graph, int root_vertex) {
+    // duals/node_of: quando pedidos, node_of[v] é o nó dual que o vértice v deste nível representa
+    InternalResult run_chu_liu(const DirectedGraph& graph, int root_vertex,
+                               ArborescenceDuals* duals = nullptr, const std::vector<int>* node_of = nullptr) {
         int n = graph.vertex_count();
         InternalResult result(n);
 
@@ -193,7 +308,8 @@ private:
             }
         }
 
-        auto cycle_detection = detect_cycles(cheapest_edges, n, root_vertex);
+        auto cycle_detection = pool ? detect_cycles_parallel(cheapest_edges, n, root_vertex)
+                                    : detect_cycles(cheapest_edges, n, root_vertex);
 
         if (cycle_detection.cycles.empty()) {
             for (int v = 0; v < n; ++v) {
@@ -202,6 +318,9 @@ private:
                 }
                 result.parent[v] = cheapest_edges[v].source;
                 result.edge_costs[v] = cheapest_edges[v].cost;
+                if (duals) {
+                    duals->value[(*node_of)[v]] = cheapest_edges[v].cost;
+                }
             }
             return result;
         }
@@ -224,38 +343,62 @@ private:
         int contracted_vertices = next_id;
         int contracted_root = component_id[root_vertex];
 
+        // Dual: y de um vértice de ciclo é o custo da aresta mais barata que entra nele,
+        // o mesmo valor descontado das arestas que entram no ciclo; cada ciclo vira um nó novo
+        std::vector<int> contracted_node_of;
+        if (duals) {
+            contracted_node_of.resize(contracted_vertices);
+            for (int v = 0; v < n; ++v) {
+                contracted_node_of[component_id[v]] = (*node_of)[v];
+            }
+            for (int c = 0; c < cycle_count; ++c) {
+                int node = duals->value.size();
+                duals->value.push_back(0.0);
+                duals->cluster_parent.push_back(-1);
+                for (int v : cycle_detection.cycles[c]) {
+                    duals->value[(*node_of)[v]] = cheapest_edges[v].cost;
+                    duals->cluster_parent[(*node_of)[v]] = node;
+                }
+                contracted_node_of[c] = node;
+            }
+        }
+
         DirectedGraph contracted(contracted_vertices);
         contracted.add_all_vertices();
 
         std::unordered_map<long long, ContractedEdgeInfo> edge_mapping;
-        edge_mapping.reserve(graph.total_connections());
-
-        auto all_edges = graph.get_all_connections();
-        for (const auto& edge : all_edges) {
-            int from_comp = component_id[edge.source];
-            int to_comp = component_id[edge.target];
-
-            if (from_comp == to_comp) {
-                continue;
-            }
-
-            double adjusted_cost = edge.cost;
-            if (cycle_detection.cycle_id_of_vertex[edge.target] != -1) {
-                adjusted_cost -= cheapest_edges[edge.target].cost;
-            }
+        std::vector<ContractedRecord> records;      // Modo paralelo: ordenado por par, no lugar de edge_mapping
+
+        EdgeList<double> all_edges = graph.edge_list(pool ? *pool : ThreadPool::serial());
+        if (pool) {
+            contracted = contract_parallel(all_edges, component_id, cheapest_edges, cycle_detection, contracted_vertices, records);
+        } else {
+            edge_mapping.reserve(all_edges.size());
+            auto crossing = [&](int source, int target, double) { return component_id[source] != component_id[target]; };
+            all_edges.for_each(crossing, [&](int source, int target, double cost) {
+                int from_comp = component_id[source];
+                int to_comp = component_id[target];
+
+                double adjusted_cost = cost;
+                if (cycle_detection.cycle_id_of_vertex[target] != -1) {
+                    adjusted_cost -= cheapest_edges[target].cost;
+                }
 
-            long long key = encode_edge_key(from_comp, to_comp);
-            bool has_connection = contracted.has_connection(from_comp, to_comp);
-            double current_cost = has_connection ? contracted.connection_cost(from_comp, to_comp) : INFINITE_COST;
+                long long key = encode_edge_key(from_comp, to_comp);
+                bool has_connection = contracted.has_connection(from_comp, to_comp);
+                double current_cost = has_connection ? contracted.connection_cost(from_comp, to_comp) : INFINITE_COST;
 
-            if (!has_connection || adjusted_cost < current_cost) {
-                contracted.connect(from_comp, to_comp, adjusted_cost);
-                edge_mapping[key] = ContractedEdgeInfo{from_comp, to_comp, adjusted_cost,
-                                                       edge.source, edge.target, edge.cost};
-            }
+                if (!has_connection || adjusted_cost < current_cost) {
+                    contracted.connect(from_comp, to_comp, adjusted_cost);
+                    edge_mapping[key] = ContractedEdgeInfo{from_comp, to_comp, adjusted_cost,
+                                                           source, target, cost};
+                }
+            });
+            // Mesma forma (e ordem de iteração) que a do modo paralelo
+            contracted.compact(ThreadPool::serial());
         }
 
-        auto contracted_result = run_chu_liu(contracted, contracted_root);
+        auto contracted_result = run_chu_liu(contracted, contracted_root, duals, duals ? &contracted_node_of : nullptr);
         if (!contracted_result.success) {
             result.success = false;
             return result;
@@ -269,6 +412,31 @@ private:
             result.edge_costs[v] = cheapest_edges[v].cost;
         }
 
+        if (pool) {
+            // Cada componente tem um vértice de entrada próprio: escritas disjuntas
+            std::atomic<bool> missing{false};
+            pool->parallel_for(0, contracted_vertices, [&](int lo, int hi) {
+                for (int comp = lo; comp < hi; ++comp) {
+                    int parent_comp = contracted_result.parent[comp];
+                    if (comp == contracted_root || parent_comp == -1) {
+                        continue;
+                    }
+                    uint64_t key = (static_cast<uint64_t>(parent_comp) << 32) | static_cast<uint32_t>(comp);
+                    auto record = std::lower_bound(records.begin(), records.end(), key,
+                                                   [](const ContractedRecord& r, uint64_t k) { return r.key < k; });
+                    if (record == records.end() || record->key != key) {
+                        missing = true;
+                        continue;
+                    }
+                    int best = record->best;
+                    result.parent[all_edges.v[best]] = all_edges.u[best];
+                    result.edge_costs[all_edges.v[best]] = all_edges.w[best];
+                }
+            });
+            result.success = !missing;
+            return result;
+        }
+
         for (int comp = 0; comp < contracted_vertices; ++comp) {
             if (comp == contracted_root) {
                 continue;
@@ -294,18 +462,32 @@ private:
     }
 
 public:
+
+    // Com pool, as fases de cada nível (mínimos, ciclos, contração) rodam em paralelo,
+    // com o mesmo resultado do modo sequencial
+    explicit EdmondsAlgorithm(ThreadPool* pool = nullptr) : pool(pool) {}
     
-    ArborescenceResult find_minimum_cost_arborescence(DirectedGraph& graph, int root_vertex) {
+    // with_duals: preenche result.duals, o certificado de minimalidade checado por ArborescenceVerifier
+    ArborescenceResult find_minimum_cost_arborescence(DirectedGraph& graph, int root_vertex, bool with_duals = false) {
         int n = graph.vertex_count();
         ArborescenceResult result(n, root_vertex);
         
         if (root_vertex < 0 || root_vertex >= n) {
             return result;
         }
-        auto internal_result = run_chu_liu(graph, root_vertex);
+        ArborescenceDuals duals;
+        std::vector<int> node_of;
+        if (with_duals) {
+            duals.cluster_parent.assign(n, -1);
+            duals.value.assign(n, 0.0);
+            node_of.resize(n);
+            std::iota(node_of.begin(), node_of.end(), 0);
+        }
+        auto internal_result = run_chu_liu(graph, root_vertex, with_duals ? &duals : nullptr, with_duals ? &node_of : nullptr);
         if (!internal_result.success) {
             return result;
         }
+        result.duals = std::move(duals);
 
         result.total_tree_cost = 0.0;
         for (int v = 0; v < n; ++v) {
@@ -337,21 +519,18 @@ public:
         int n = graph.vertex_count();
         ArborescenceResult result(n, -1); // Sem raiz única
         
-        // Arestas direcionadas em pares não direcionados com menor custo
-        std::vector<DirectedEdge> edges = graph.get_minimum_undirected_edges();
-
-        // Ordena arestas por peso crescente
-        std::sort(edges.begin(), edges.end(),
-                  [](const DirectedEdge& a, const DirectedEdge& b) {
-                      return a.cost < b.cost;
-                  });
+        // Arestas direcionadas em pares não direcionados com menor custo, já em ordem (u, v)
+        EdgeList<double> edges = graph.minimum_undirected_edge_list();
+
+        // Ordenação estável só das chaves: ordem final (peso, u, v), independente do hash
+        std::vector<uint32_t> order = edges.sorted_order();
         
         // Union-Find para segmentação
         UnionFind uf(n);
         
         // Segmentação principal
-        for (const auto& edge : edges) {
-            uf.join(edge.source, edge.target, edge.cost, k);
+        for (uint32_t i : order) {
+            uf.join(edges.u[i], edges.v[i], edges.w[i], k);
         }
         
         // Compressão final de caminhos para consistência
@@ -1,60 +1,71 @@
 #include "../graph/Graph.h"
-#include "../graph/edge.h"
-#include <queue>
+#include "../graph/EdgeList.h"
 #include <stack>
 #include <unordered_map>
 #include <vector>
 
-struct minHeap {
-	bool operator()(const Edge& a, const Edge& b) const {
-		bool res = false;
-		if (a.w != b.w) {
-			res = (a.w > b.w);
-		} else { 
-			res = (a.u < b.u || a.v < b.v);
-		}
-		return (res);
-	}
-};
+// Edges from every pixel to i+1, i+width and i+width+1, in that order (so in (u, v) order)
+// weights_of(u, v, push) calls push(w) for every weight of u -> v
+template <typename W, typename WeightsOf>
+EdgeList<W> kruskal_edges(int vert_n, int width, WeightsOf weights_of) {
 
-// Get a MST from kruskal's algorithm
-// ! Should not be called when g is directed !
-WeightedGraph* kruskal_segmentation (WeightedGraph G, WeightedGraph* S, int width, int k) {
-	
-	std::priority_queue<Edge,  std::vector<Edge>, minHeap> pq;
-	int vert_n = S->vert_count();
+	EdgeList<W> edges;
+	edges.reserve(static_cast<size_t>(vert_n) * 3);
 
-	// Find edges
 	for (int i = 0; i < vert_n; i++) {
 
 		int i1 = i+1;
 		int iw = i+width;
 		int iw1 = iw+1;
 
+		auto push_edge = [&](int other) {
+			weights_of(i, other, [&](W w) {
+				edges.push_back(i, other, w);
+			});
+		};
+
 		if ((i1 % width) != 0) {
-			std::vector<double> weights = S->get_weight(i, i1);
-			for (double w : weights) {
-				pq.push(Edge(i, i1, w));
-			}
+			push_edge(i1);
 		}
 		if ((iw % width) != 0) {
-			std::vector<double> weights = S->get_weight(i, iw);
-			for (double w : weights) {
-				pq.push(Edge(i, iw, w));
-			}
+			push_edge(iw);
 		}
 		if ((iw1 % width) != 0) {
-			std::vector<double> weights = S->get_weight(i, iw1);
-			for (double w : weights) {
-				pq.push(Edge(i, iw1, w));
-			}
+			push_edge(iw1);
 		}
-	} 
+	}
+	return edges;
+}
 
-	// Create the MST's Graph
-	WeightedGraph* T = new WeightedGraph(vert_n);
-	T->all_verts();
-	T->setPixColor(S->getPixColor());
+template <typename Graph>
+EdgeList<typename Graph::weight_type> kruskal_edges(const Graph& S, int width) {
+	return kruskal_edges<typename Graph::weight_type>(S.vert_count(), width, [&](int u, int v, auto push) {
+		S.for_each_weight(u, v, push);
+	});
+}
+
+// Same edges read straight from a mapped graph file: one pass over each row keeps the
+// entries that go to u+1 .. u+width+1
+inline EdgeList<double> kruskal_edges(const MappedGraph& S, int width) {
+	int row_of = -1;
+	std::vector<std::pair<int, double>> row;
+	return kruskal_edges<double>(S.vert_count(), width, [&](int u, int v, auto push) {
+		if (row_of != u) {
+			row_of = u;
+			row.clear();
+			S.for_each_edge(u, [&](int target, double w) {
+				if (target > u && target <= u + width + 1) row.emplace_back(target, w);
+			});
+		}
+		for (const auto& [target, w] : row) {
+			if (target == v) push(w);
+		}
+	});
+}
+
+// Segment root of every pixel; on_merge(u, v, w) sees each MST edge that joins two segments
+template <typename W, typename OnMerge>
+std::vector<int> kruskal_segments(const EdgeList<W>& edges, int vert_n, int k, OnMerge on_merge) {
 
 	std::vector<std::vector<int>> union_find(3, std::vector<int>(vert_n));
 	for (int i = 0; i < vert_n; i++) {
@@ -63,14 +74,15 @@ WeightedGraph* kruskal_segmentation (WeightedGraph G, WeightedGraph* S, int widt
 		union_find[2][i] = 0; // internal distance
 	}
 
-	int edge_n = pq.size();
+	// Lightest first, ties by (u, v): sorted_order() is stable by (weight, position)
+	// and kruskal_edges pushes the edges in (u, v) order
+	std::vector<uint32_t> order = edges.sorted_order();
 
 	// Union find
-	for (int i = 0; i < edge_n; i++) {
+	for (uint32_t position : order) {
+
+		Edge e = edges.edge(position);
 
-		Edge e = pq.top();
-		pq.pop();
-		
 		int u = e.u;
 		int v = e.v;
 		int ancestor_u = u;
@@ -100,7 +112,7 @@ WeightedGraph* kruskal_segmentation (WeightedGraph G, WeightedGraph* S, int widt
 			);
 			
 			if (Mint >= e.w) {
-				T->add_edge(u, v, e.w);
+				on_merge(u, v, e.w);
 
 				// If u's ancestor has a higher or equal rank
 				if (union_find[1][ancestor_u] >= union_find[1][ancestor_v]) { 
@@ -123,23 +135,47 @@ WeightedGraph* kruskal_segmentation (WeightedGraph G, WeightedGraph* S, int widt
 		}
 	}
 
-	// Paint components
-
-	std::vector<RGB> colors_original = G.getPixColor();
-	std::vector<RGB> colors_sobel = S->getPixColor();
-
 	for (int i = 0; i < vert_n; i++) {
 		int ancestor_u = i;
 		while (ancestor_u != union_find[0][ancestor_u]) {
 			ancestor_u = union_find[0][ancestor_u];
 		}
 		union_find[0][i] = ancestor_u;
-		colors_sobel[i] = colors_original[ancestor_u];
+	}
+	return std::move(union_find[0]);
+}
+
+template <typename W>
+std::vector<int> kruskal_segments(const EdgeList<W>& edges, int vert_n, int k) {
+	return kruskal_segments(edges, vert_n, k, [](int, int, double) {});
+}
+
+// Get a MST from kruskal's algorithm
+// ! Should not be called when g is directed !
+// G only provides the original pixel colors
+template <typename Graph>
+Graph* kruskal_segmentation (const Graph& G, Graph* S, int width, int k) {
+
+	int vert_n = S->vert_count();
+
+	// Create the MST's Graph
+	Graph* T = new Graph(vert_n);
+	T->all_verts();
+
+	std::vector<int> root = kruskal_segments(kruskal_edges(*S, width), vert_n, k, [&](int u, int v, double w) {
+		T->add_edge(u, v, w);
+	});
+
+	// Paint components
+
+	std::vector<RGB> colors_original = G.getPixColor();
+	std::vector<RGB> colors_sobel = S->getPixColor();
+
+	for (int i = 0; i < vert_n; i++) {
+		colors_sobel[i] = colors_original[root[i]];
 	}
 
 	T->setPixColor(colors_sobel);
 
 	return (T);
 }
-
-
@@ -2,9 +2,9 @@
 #define GABOW_ARBORESCENCE_H
 
 #include "arborescence.h"
+#include "verifier.h"
 #include <algorithm>
 #include <limits>
-#include <stack>
 #include <vector>
 
 class GabowArborescence {
@@ -44,7 +44,10 @@ public:
         }
 
         // Fase 2: Lidar com ciclos iterativamente
+        // A troca de arestas pode oscilar entre ciclos para sempre (grades, grafos aleatórios
+        // densos): depois de n rodadas desiste e o resultado fica incompleto
         bool changed;
+        int rounds = 0;
         do {
             changed = false;
             auto cycles = find_cycles(parent, root_vertex);
@@ -72,10 +75,10 @@ public:
                     }
                 }
             }
-        } while (changed);
+        } while (changed && ++rounds < n);
 
         // Verificar resultado final
-        if (is_valid_arborescence(parent, root_vertex)) {
+        if (ArborescenceVerifier::is_arborescence(parent, root_vertex)) {
             result.parent_of = parent;
             result.edge_costs = cost;
             result.total_tree_cost = total_cost;
@@ -94,13 +97,12 @@ private:
         for (int v = 0; v < n; ++v) {
             if (v == root) continue;
             
-            auto sources = graph.get_sources_to(v);
-            for (const auto &[u, cost] : sources) {
+            graph.for_each_source(v, [&](int u, double cost) {
                 if (cost < min_costs[v]) {
                     min_costs[v] = cost;
                     min_edges[v] = DirectedEdge(u, v, cost);
                 }
-            }
+            });
         }
         return min_edges;
     }
@@ -157,40 +159,14 @@ private:
         double min_cost = INF;
         DirectedEdge best_edge;
 
-        auto sources = graph.get_sources_to(target);
-        for (const auto &[u, cost] : sources) {
+        graph.for_each_source(target, [&](int u, double cost) {
             if (u != exclude_source && u != target && cost < min_cost) {
                 min_cost = cost;
                 best_edge = DirectedEdge(u, target, cost);
             }
-        }
+        });
         return best_edge;
     }
-
-    bool is_valid_arborescence(const std::vector<int> &parent, int root) {
-        int n = parent.size();
-        std::vector<bool> visited(n, false);
-        std::stack<int> stack;
-        
-        stack.push(root);
-        visited[root] = true;
-        int visited_count = 1;
-
-        while (!stack.empty()) {
-            int u = stack.top();
-            stack.pop();
-
-            for (int v = 0; v < n; ++v) {
-                if (parent[v] == u && !visited[v]) {
-                    visited[v] = true;
-                    visited_count++;
-                    stack.push(v);
-                }
-            }
-        }
-
-        return visited_count == n;
-    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,271 @@
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include "../graph/Graph.h"
+#include "../graph/edge.h"
+#include "arborescence.h"
+#include "boruvka.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+// Felzenszwalb segmentation for every k from a single sorted pass
+//
+// Hierarchical Felzenszwalb (Guimarães et al., 2017): the edges are sorted once,
+// the minimum spanning forest is swept in that order and each forest edge gets
+// its observation scale, the smallest k for which the regions it joins at that k
+// pass the Felzenszwalb test  w <= Int(R) + k/|R|  on both sides.
+// The merge tree (dendrogram) of the forest ordered by scale then gives nested
+// segmentations, and the one for any k is read in O(n) without recomputing.
+//
+// Regions only grow through forest edges, so the result is close to, not
+// identical with, a separate segment_image / kruskal_segmentation run for that k.
+class SegmentationHierarchy {
+
+public:
+
+    struct Merge {
+        int left;           // Node ids: 0..n-1 are vertices, n+i is merges[i]
+        int right;
+        double weight;      // Edge weight that joined left and right
+        double scale;       // Smallest k for which this merge happens
+        int size;           // Vertices under this node
+        int representative; // Smallest vertex under this node
+    };
+
+private:
+
+    int n;
+    std::vector<Merge> merge_list;
+    std::vector<int> parent_node; // Parent merge node of each node, -1 for roots
+
+public:
+
+    SegmentationHierarchy(int vertex_count, std::vector<Edge> edges)
+    : n(vertex_count), parent_node(vertex_count, -1) {
+        std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+            return a.w < b.w;
+        });
+        std::vector<Edge> forest = spanning_forest(edges);
+        std::vector<double> scale = observation_scales(forest);
+        build_merge_tree(forest, scale);
+    }
+
+    // Minimum spanning forest already sorted by weight (as BoruvkaMST returns it)
+    static SegmentationHierarchy from_spanning_forest(int vertex_count, const std::vector<Edge>& forest) {
+        SegmentationHierarchy res(vertex_count);
+        res.build_merge_tree(forest, res.observation_scales(forest));
+        return res;
+    }
+
+    // Undirected edges of a WeightedGraph (smallest weight of each pair), forest by parallel Borůvka
+    template <typename W, template <typename> class Multiplicity>
+    static SegmentationHierarchy from_weighted_graph(const BasicWeightedGraph<W, Multiplicity>& graph) {
+        return from_spanning_forest(graph.vert_count(), BoruvkaMST::spanning_forest(graph));
+    }
+
+    // Same, straight from a mapped graph file
+    static SegmentationHierarchy from_mapped(const MappedGraph& graph) {
+        return from_spanning_forest(graph.vert_count(), BoruvkaMST::spanning_forest(graph));
+    }
+
+    // Same pairs as EdmondsAlgorithm::segment_image
+    static SegmentationHierarchy from_directed_graph(const DirectedGraph& graph) {
+        std::vector<DirectedEdge> pairs = graph.get_minimum_undirected_edges();
+        std::vector<Edge> edges;
+        edges.reserve(pairs.size());
+        for (const DirectedEdge& e : pairs) {
+            edges.emplace_back(e.source, e.target, e.cost);
+        }
+        return SegmentationHierarchy(graph.vertex_count(), std::move(edges));
+    }
+
+    int vertex_count() const {
+        return n;
+    }
+
+    const std::vector<Merge>& merges() const {
+        return merge_list;
+    }
+
+    // Segment of every vertex for this k, as its smallest vertex; O(n)
+    std::vector<int> labels_for(double k) const {
+        int nodes = n + static_cast<int>(merge_list.size());
+        std::vector<int> label(nodes);
+        // Parents always have larger ids, so one descending pass settles every node
+        for (int node = nodes - 1; node >= 0; node--) {
+            int parent = parent_node[node];
+            if (parent != -1 && merge_list[parent - n].scale <= k) {
+                label[node] = label[parent];
+            }
+            else {
+                label[node] = representative_of(node);
+            }
+        }
+        label.resize(n);
+        return label;
+    }
+
+    int segment_count(double k) const {
+        int count = n;
+        for (const Merge& m : merge_list) {
+            if (m.scale <= k) count--;
+        }
+        return count;
+    }
+
+    // Labels in the format of EdmondsAlgorithm::segment_image (parent_of = segment root)
+    ArborescenceResult segment(double k) const {
+        ArborescenceResult result(n, -1);
+        result.parent_of = labels_for(k);
+        result.is_complete = true;
+        return result;
+    }
+
+private:
+
+    explicit SegmentationHierarchy(int vertex_count)
+    : n(vertex_count), parent_node(vertex_count, -1) {}
+
+    int representative_of(int node) const {
+        return node < n ? node : merge_list[node - n].representative;
+    }
+
+    // Kruskal over the sorted edges; the forest keeps the sorted order
+    std::vector<Edge> spanning_forest(const std::vector<Edge>& sorted_edges) const {
+        std::vector<int> uf(n);
+        std::iota(uf.begin(), uf.end(), 0);
+        auto find = [&](int x) {
+            while (uf[x] != x) {
+                uf[x] = uf[uf[x]];
+                x = uf[x];
+            }
+            return x;
+        };
+
+        std::vector<Edge> forest;
+        forest.reserve(n > 0 ? n - 1 : 0);
+        for (const Edge& e : sorted_edges) {
+            int a = find(e.u);
+            int b = find(e.v);
+            if (a != b) {
+                uf[a] = b;
+                forest.push_back(e);
+            }
+        }
+        return forest;
+    }
+
+    // Smallest k at which each forest edge joins its two regions (Guimarães et al.)
+    // A binary partition tree ordered by scale is kept for the edges seen so far;
+    // the ancestors of a vertex are its regions for increasing k
+    std::vector<double> observation_scales(const std::vector<Edge>& forest) const {
+        const double INF = std::numeric_limits<double>::infinity();
+        int nodes = n + static_cast<int>(forest.size());
+        std::vector<int> parent(nodes, -1);
+        std::vector<double> altitude(nodes, 0.0);
+        std::vector<int> size(nodes, 1);
+        std::vector<double> internal(nodes, 0.0); // Int(R): heaviest forest edge inside R
+
+        auto parent_altitude = [&](int node) {
+            return parent[node] == -1 ? INF : altitude[parent[node]];
+        };
+
+        std::vector<double> scale(forest.size());
+        for (int i = 0; i < (int)forest.size(); i++) {
+            const Edge& e = forest[i];
+
+            // Walk both ancestor chains until the regions at some k accept the edge
+            int rx = e.u;
+            int ry = e.v;
+            double lambda;
+            while (true) {
+                double required = std::max((e.w - internal[rx]) * size[rx], (e.w - internal[ry]) * size[ry]);
+                double candidate = std::max(required, std::max(altitude[rx], altitude[ry]));
+                double next_x = parent_altitude(rx);
+                double next_y = parent_altitude(ry);
+                double next = std::min(next_x, next_y);
+                if (candidate < next) {
+                    lambda = candidate;
+                    break;
+                }
+                if (next_x <= next_y) rx = parent[rx];
+                if (next_y <= next_x) ry = parent[ry];
+            }
+            scale[i] = lambda;
+
+            // New node above both regions, then zip the two ancestor chains by altitude
+            int node = n + i;
+            altitude[node] = lambda;
+            size[node] = size[rx] + size[ry];
+            internal[node] = e.w;
+            int a = parent[rx], b = parent[ry];
+            int old_a = size[rx], old_b = size[ry];
+            parent[rx] = node;
+            parent[ry] = node;
+
+            int current = node;
+            while (a != -1 || b != -1) {
+                bool take_a = (b == -1) || (a != -1 && altitude[a] <= altitude[b]);
+                int next = take_a ? a : b;
+                int& old_child_size = take_a ? old_a : old_b;
+                int next_parent = parent[next];
+                int next_old_size = size[next];
+
+                // Region grows by what the other chain brought in below it
+                size[next] = size[next] - old_child_size + size[current];
+                internal[next] = std::max(internal[next], internal[current]);
+                parent[current] = next;
+
+                old_child_size = next_old_size;
+                (take_a ? a : b) = next_parent;
+                current = next;
+            }
+            parent[current] = -1;
+        }
+        return scale;
+    }
+
+    // Dendrogram of the forest ordered by scale; node ids grow towards the root
+    void build_merge_tree(const std::vector<Edge>& forest, const std::vector<double>& scale) {
+        std::vector<int> order(forest.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return scale[a] < scale[b];
+        });
+
+        std::vector<int> uf(n);
+        std::iota(uf.begin(), uf.end(), 0);
+        std::vector<int> node_of(n);
+        std::iota(node_of.begin(), node_of.end(), 0);
+        auto find = [&](int x) {
+            while (uf[x] != x) {
+                uf[x] = uf[uf[x]];
+                x = uf[x];
+            }
+            return x;
+        };
+
+        merge_list.reserve(forest.size());
+        for (int idx : order) {
+            const Edge& e = forest[idx];
+            int a = find(e.u);
+            int b = find(e.v);
+            int left = node_of[a];
+            int right = node_of[b];
+            int id = n + static_cast<int>(merge_list.size());
+            int size_left = left < n ? 1 : merge_list[left - n].size;
+            int size_right = right < n ? 1 : merge_list[right - n].size;
+            merge_list.push_back(Merge{left, right, e.w, scale[idx], size_left + size_right,
+                                       std::min(representative_of(left), representative_of(right))});
+            parent_node[left] = id;
+            parent_node[right] = id;
+            parent_node.push_back(-1);
+            uf[a] = b;
+            node_of[b] = id;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include "../graph/PixelMetric.h"
+#include "../graph/edge.h"
+#include "arborescence.h"
+#include "unionfind.h"
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+// Coarse-to-fine Felzenszwalb segmentation
+//
+// The color and gradient images are halved `levels` times (2x2 mean). The coarsest
+// level is segmented in full; at every finer level only the pixels under coarse
+// region boundaries are segmented again, while interior pixels inherit the label
+// of their coarse parent (seeded as already merged components). The work per
+// level is proportional to the boundary length instead of the pixel count.
+//
+// Edge weights are those of WeightedGraph::from_color_and_gradient and the merge
+// test is the one of EdmondsAlgorithm::segment_image, with k divided by 4 per
+// level so that k/|C| stays in full-resolution pixels.
+class PyramidSegmentation {
+
+private:
+
+    // Level 0 points at the caller's images, the others at `storage`
+    struct Level {
+        const std::vector<std::vector<std::vector<int>>> *color;
+        const std::vector<std::vector<std::vector<int>>> *gradient;
+        int width;
+        int height;
+        FeaturePlanes features;     // Filled once the level is built
+    };
+
+    std::deque<std::vector<std::vector<std::vector<int>>>> storage;
+
+    double color_scale;
+    double gradient_scale;
+    double k;
+    int levels;
+    long long refined_pixels; // Pixels segmented again during the last run (all levels)
+
+public:
+
+    PyramidSegmentation(double color_scale, double gradient_scale, double k, int levels)
+    : color_scale(color_scale), gradient_scale(gradient_scale), k(k), levels(levels), refined_pixels(0) {}
+
+    long long last_refined_pixels() const {
+        return refined_pixels;
+    }
+
+    // Labels in the format of EdmondsAlgorithm::segment_image (parent_of = segment root)
+    ArborescenceResult segment(
+        const std::vector<std::vector<std::vector<int>>> &color_img,
+        const std::vector<std::vector<std::vector<int>>> &gradient_img,
+        int width, int height
+    ) {
+        storage.clear();
+        std::vector<Level> pyramid;
+        pyramid.push_back(Level{&color_img, &gradient_img, width, height, {}});
+        while ((int)pyramid.size() <= levels && pyramid.back().width >= 32 && pyramid.back().height >= 32) {
+            pyramid.push_back(downsample(pyramid.back()));
+        }
+        for (Level &level : pyramid) {
+            level.features.assign(*level.color, *level.gradient, level.width, level.height);
+        }
+
+        int top = pyramid.size() - 1;
+        std::vector<int> labels;
+        std::vector<double> internal; // Int(C) of each label (indexed by the label's root pixel)
+        segment_level(pyramid[top], level_k(top), labels, internal);
+        refined_pixels = (long long)pyramid[top].width * pyramid[top].height;
+
+        for (int l = top - 1; l >= 0; l--) {
+            refine_level(pyramid[l + 1], pyramid[l], level_k(l), labels, internal);
+        }
+
+        int n = width * height;
+        ArborescenceResult result(n, -1);
+        result.parent_of = labels;
+        result.is_complete = true;
+        return result;
+    }
+
+private:
+
+    double level_k(int level) const {
+        return k / (double)(1LL << (2 * level));
+    }
+
+    Level downsample(const Level &fine) {
+        Level coarse;
+        coarse.width = (fine.width + 1) / 2;
+        coarse.height = (fine.height + 1) / 2;
+        auto &color = storage.emplace_back(coarse.height, std::vector<std::vector<int>>(coarse.width, std::vector<int>(3)));
+        auto &gradient = storage.emplace_back(coarse.height, std::vector<std::vector<int>>(coarse.width, std::vector<int>(3)));
+        coarse.color = &color;
+        coarse.gradient = &gradient;
+
+        for (int y = 0; y < coarse.height; y++) {
+            for (int x = 0; x < coarse.width; x++) {
+                int count = 0;
+                int color_sum[3] = {0, 0, 0};
+                int gradient_sum[3] = {0, 0, 0};
+                for (int fy = 2 * y; fy < std::min(fine.height, 2 * y + 2); fy++) {
+                    for (int fx = 2 * x; fx < std::min(fine.width, 2 * x + 2); fx++) {
+                        for (int c = 0; c < 3; c++) {
+                            color_sum[c] += (*fine.color)[fy][fx][c];
+                            gradient_sum[c] += (*fine.gradient)[fy][fx][c];
+                        }
+                        count++;
+                    }
+                }
+                for (int c = 0; c < 3; c++) {
+                    color[y][x][c] = color_sum[c] / count;
+                    gradient[y][x][c] = gradient_sum[c] / count;
+                }
+            }
+        }
+        return coarse;
+    }
+
+    double weight(const Level &level, int p, int q) const {
+        return level.features.weight(p, q, pixel_metric::GradientBlended<>{color_scale, gradient_scale});
+    }
+
+    static void sort_edges(std::vector<Edge> &edges) {
+        std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+            return a.w < b.w;
+        });
+    }
+
+    static void collect_labels(SegmentUnionFind &uf, int n, std::vector<int> &labels, std::vector<double> &internal) {
+        labels.resize(n);
+        internal.assign(n, 0.0);
+        for (int p = 0; p < n; p++) {
+            labels[p] = uf.find(p);
+        }
+        for (int p = 0; p < n; p++) {
+            if (labels[p] == p) internal[p] = uf.internal_cost[p];
+        }
+    }
+
+    // Plain Felzenszwalb over the 8-neighbourhood of the coarsest level
+    void segment_level(const Level &level, double level_k, std::vector<int> &labels, std::vector<double> &internal) const {
+        int w = level.width, h = level.height, n = w * h;
+        std::vector<Edge> edges;
+        edges.reserve(4 * n);
+        for (int p = 0; p < n; p++) {
+            int x = p % w, y = p / w;
+            if (x > 0 && y < h - 1) edges.emplace_back(p, p + w - 1, weight(level, p, p + w - 1));
+            if (y < h - 1) edges.emplace_back(p, p + w, weight(level, p, p + w));
+            if (x < w - 1 && y < h - 1) edges.emplace_back(p, p + w + 1, weight(level, p, p + w + 1));
+            if (x < w - 1) edges.emplace_back(p, p + 1, weight(level, p, p + 1));
+        }
+        sort_edges(edges);
+
+        SegmentUnionFind uf(n);
+        for (const Edge &e : edges) {
+            uf.join(e.u, e.v, e.w, level_k);
+        }
+        collect_labels(uf, n, labels, internal);
+    }
+
+    // Labels of `fine` from those of `coarse`: interior pixels inherit, boundary band is re-segmented
+    void refine_level(const Level &coarse, const Level &fine, double level_k,
+                      std::vector<int> &labels, std::vector<double> &internal) {
+        int cw = coarse.width, ch = coarse.height;
+        int fw = fine.width, fh = fine.height, fn = fw * fh;
+
+        // Coarse pixels with a differently labeled 8-neighbour
+        std::vector<char> boundary(cw * ch, 0);
+        for (int cy = 0; cy < ch; cy++) {
+            for (int cx = 0; cx < cw; cx++) {
+                int c = cx + cy * cw;
+                for (int dy = -1; dy <= 1 && !boundary[c]; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int nx = cx + dx, ny = cy + dy;
+                        if (nx < 0 || ny < 0 || nx >= cw || ny >= ch) continue;
+                        if (labels[nx + ny * cw] != labels[c]) {
+                            boundary[c] = 1;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Interior pixels start merged with their coarse region, band pixels start alone
+        SegmentUnionFind uf(fn);
+        std::vector<int> rep_of(cw * ch, -1);
+        std::vector<char> band(fn, 0);
+        for (int p = 0; p < fn; p++) {
+            int c = (p % fw) / 2 + ((p / fw) / 2) * cw;
+            if (boundary[c]) {
+                band[p] = 1;
+                continue;
+            }
+            int label = labels[c];
+            if (rep_of[label] == -1) {
+                rep_of[label] = p;
+                uf.internal_cost[p] = internal[label];
+            }
+            else {
+                uf.parent[p] = rep_of[label];
+                uf.size[rep_of[label]]++;
+            }
+        }
+
+        // Edges touching the band (interior-interior pairs always share a label)
+        std::vector<Edge> edges;
+        for (int p = 0; p < fn; p++) {
+            if (!band[p]) continue;
+            refined_pixels++;
+            int x = p % fw, y = p / fw;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    int nx = x + dx, ny = y + dy;
+                    if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= fw || ny >= fh) continue;
+                    int q = nx + ny * fw;
+                    if (!band[q] || p < q) {
+                        edges.emplace_back(p, q, weight(fine, p, q));
+                    }
+                }
+            }
+        }
+        sort_edges(edges);
+
+        for (const Edge &e : edges) {
+            uf.join(e.u, e.v, e.w, level_k);
+        }
+        collect_labels(uf, fn, labels, internal);
+    }
+};
+
+#endif
@@ -0,0 +1,319 @@
+#ifndef RAG_H
+#define RAG_H
+
+#include "../graph/PixelMetric.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// Region adjacency graph of a segmentation
+//
+// Built from the final label of every pixel (any ids in [0, n), e.g. union-find
+// roots or ArborescenceResult::parent_of) in one pass over the pixels and their
+// 4 forward neighbours: per-region size, color sums and bounding box, and per
+// pair of touching regions the boundary length and the sum / min / max of the
+// pixel metric across it.
+//
+// merge() then joins regions greedily, cheapest pair first, with a heap of
+// candidate boundaries. The cost of a pair comes from a criterion functor
+// double(const Region&, const Region&, const Boundary&); infinity means never.
+class RegionAdjacencyGraph {
+
+public:
+
+    struct Region {
+        int size = 0;
+        long long r_sum = 0;
+        long long g_sum = 0;
+        long long b_sum = 0;
+        int min_x = std::numeric_limits<int>::max();
+        int min_y = std::numeric_limits<int>::max();
+        int max_x = -1;
+        int max_y = -1;
+        int representative = -1;    // Smallest pixel of the region
+
+        double mean_r() const { return (double)r_sum / size; }
+        double mean_g() const { return (double)g_sum / size; }
+        double mean_b() const { return (double)b_sum / size; }
+    };
+
+    struct Boundary {
+        int a;                      // Region ids, a < b when built
+        int b;
+        int length = 0;             // Neighbouring pixel pairs across the boundary
+        double weight_sum = 0.0;
+        double min_weight = std::numeric_limits<double>::infinity();
+        double max_weight = 0.0;
+
+        double mean_weight() const { return weight_sum / length; }
+    };
+
+private:
+
+    int width;
+    int height;
+    std::vector<int> region_of;
+    std::vector<Region> region_list;
+    std::vector<Boundary> boundary_list;
+
+    // Merge state
+    std::vector<int> parent;
+    std::vector<int> version;
+    std::vector<char> boundary_alive;
+    std::vector<std::unordered_map<int, int>> adjacent;  // Neighbour region -> boundary
+    int alive_regions;
+
+    static long long pair_key(int a, int b) {
+        if (a > b) std::swap(a, b);
+        return ((long long)a << 32) | (unsigned int)b;
+    }
+
+    int find(int r) {
+        while (parent[r] != r) {
+            parent[r] = parent[parent[r]];
+            r = parent[r];
+        }
+        return r;
+    }
+
+    RegionAdjacencyGraph(int width, int height) : width(width), height(height), alive_regions(0) {}
+
+public:
+
+    template <typename Metric>
+    static RegionAdjacencyGraph from_labels(const std::vector<int> &labels, const FeaturePlanes &planes, const Metric &metric) {
+        int w = planes.width, h = planes.height, n = planes.size();
+        if ((int)labels.size() != n) {
+            throw std::invalid_argument("One label per pixel expected");
+        }
+        RegionAdjacencyGraph rag(w, h);
+
+        // Dense region ids in pixel order
+        std::vector<int> dense(n, -1);
+        rag.region_of.resize(n);
+        for (int p = 0; p < n; p++) {
+            int label = labels[p];
+            if (label < 0 || label >= n) {
+                throw std::invalid_argument("Labels must be in [0, n)");
+            }
+            if (dense[label] == -1) {
+                dense[label] = rag.region_list.size();
+                rag.region_list.emplace_back();
+                rag.region_list.back().representative = p;
+            }
+            rag.region_of[p] = dense[label];
+        }
+
+        std::unordered_map<long long, int> boundary_of;
+        long long last_key = -1;
+        int last_boundary = -1;
+        auto touch = [&](int p, int q) {
+            int a = rag.region_of[p], b = rag.region_of[q];
+            if (a == b) return;
+            long long key = pair_key(a, b);
+            // Consecutive pixels along a boundary mostly hit the same pair
+            if (key != last_key) {
+                auto [it, created] = boundary_of.try_emplace(key, (int)rag.boundary_list.size());
+                if (created) {
+                    rag.boundary_list.push_back(Boundary{std::min(a, b), std::max(a, b)});
+                }
+                last_key = key;
+                last_boundary = it->second;
+            }
+            Boundary &e = rag.boundary_list[last_boundary];
+            double weight = planes.weight(p, q, metric);
+            e.length++;
+            e.weight_sum += weight;
+            e.min_weight = std::min(e.min_weight, weight);
+            e.max_weight = std::max(e.max_weight, weight);
+        };
+
+        for (int p = 0; p < n; p++) {
+            int x = p % w, y = p / w;
+            Region &r = rag.region_list[rag.region_of[p]];
+            r.size++;
+            r.r_sum += planes.r[p];
+            r.g_sum += planes.g[p];
+            r.b_sum += planes.b[p];
+            r.min_x = std::min(r.min_x, x);
+            r.min_y = std::min(r.min_y, y);
+            r.max_x = std::max(r.max_x, x);
+            r.max_y = std::max(r.max_y, y);
+
+            if (x > 0 && y < h - 1) touch(p, p + w - 1);
+            if (y < h - 1) touch(p, p + w);
+            if (x < w - 1 && y < h - 1) touch(p, p + w + 1);
+            if (x < w - 1) touch(p, p + 1);
+        }
+
+        int regions = rag.region_list.size();
+        rag.parent.resize(regions);
+        for (int r = 0; r < regions; r++) rag.parent[r] = r;
+        rag.version.assign(regions, 0);
+        rag.boundary_alive.assign(rag.boundary_list.size(), 1);
+        rag.adjacent.resize(regions);
+        for (int i = 0; i < (int)rag.boundary_list.size(); i++) {
+            rag.adjacent[rag.boundary_list[i].a][rag.boundary_list[i].b] = i;
+            rag.adjacent[rag.boundary_list[i].b][rag.boundary_list[i].a] = i;
+        }
+        rag.alive_regions = regions;
+        return rag;
+    }
+
+    // Current number of regions (after merges)
+    int region_count() const {
+        return alive_regions;
+    }
+
+    // Regions and boundaries as built; merged regions live on in their survivor
+    const std::vector<Region>& regions() const {
+        return region_list;
+    }
+
+    const std::vector<Boundary>& boundaries() const {
+        return boundary_list;
+    }
+
+    // Greedy merging, cheapest pair first, while the cost is <= max_cost and more
+    // than min_regions are left; returns the number of merges
+    template <typename Criterion>
+    int merge(const Criterion &criterion, double max_cost = std::numeric_limits<double>::infinity(), int min_regions = 1) {
+        struct Candidate {
+            double cost;
+            int boundary;
+            int version_a;
+            int version_b;
+            bool operator< (const Candidate &other) const {
+                return cost > other.cost || (cost == other.cost && boundary > other.boundary);
+            }
+        };
+        std::priority_queue<Candidate> heap;
+        auto push = [&](int i) {
+            const Boundary &e = boundary_list[i];
+            double cost = criterion(region_list[e.a], region_list[e.b], e);
+            if (cost < std::numeric_limits<double>::infinity() && cost <= max_cost) {
+                heap.push(Candidate{cost, i, version[e.a], version[e.b]});
+            }
+        };
+        for (int i = 0; i < (int)boundary_list.size(); i++) {
+            if (boundary_alive[i]) push(i);
+        }
+
+        int merges = 0;
+        while (!heap.empty() && alive_regions > min_regions) {
+            Candidate top = heap.top();
+            heap.pop();
+            if (!boundary_alive[top.boundary]) continue;
+            Boundary &joined = boundary_list[top.boundary];
+            if (version[joined.a] != top.version_a || version[joined.b] != top.version_b) continue;
+
+            // Keep the region with more neighbours, fold the other one into it
+            int keep = joined.a, gone = joined.b;
+            if (adjacent[keep].size() < adjacent[gone].size()) std::swap(keep, gone);
+            boundary_alive[top.boundary] = 0;
+            adjacent[keep].erase(gone);
+            adjacent[gone].erase(keep);
+
+            Region &k = region_list[keep];
+            const Region &g = region_list[gone];
+            k.size += g.size;
+            k.r_sum += g.r_sum;
+            k.g_sum += g.g_sum;
+            k.b_sum += g.b_sum;
+            k.min_x = std::min(k.min_x, g.min_x);
+            k.min_y = std::min(k.min_y, g.min_y);
+            k.max_x = std::max(k.max_x, g.max_x);
+            k.max_y = std::max(k.max_y, g.max_y);
+            k.representative = std::min(k.representative, g.representative);
+            parent[gone] = keep;
+
+            for (const auto &[other, i] : adjacent[gone]) {
+                adjacent[other].erase(gone);
+                auto existing = adjacent[keep].find(other);
+                if (existing == adjacent[keep].end()) {
+                    Boundary &e = boundary_list[i];
+                    (e.a == gone ? e.a : e.b) = keep;
+                    adjacent[keep][other] = i;
+                    adjacent[other][keep] = i;
+                }
+                else {
+                    // Both touched `other`: one boundary with both pixel pairs
+                    Boundary &into = boundary_list[existing->second];
+                    const Boundary &from = boundary_list[i];
+                    into.length += from.length;
+                    into.weight_sum += from.weight_sum;
+                    into.min_weight = std::min(into.min_weight, from.min_weight);
+                    into.max_weight = std::max(into.max_weight, from.max_weight);
+                    boundary_alive[i] = 0;
+                }
+            }
+            adjacent[gone].clear();
+            version[keep]++;
+            version[gone]++;
+            alive_regions--;
+            merges++;
+
+            for (const auto &[other, i] : adjacent[keep]) {
+                push(i);
+            }
+        }
+        return merges;
+    }
+
+    // Final region of every pixel, as its smallest pixel (labels for saveSegments & co.)
+    std::vector<int> labels() {
+        int n = width * height;
+        std::vector<int> res(n);
+        for (int p = 0; p < n; p++) {
+            res[p] = region_list[find(region_of[p])].representative;
+        }
+        return res;
+    }
+};
+
+// Criteria for RegionAdjacencyGraph::merge
+namespace region_merge {
+
+// Distance between the mean colors
+struct MeanColor {
+    double operator()(const RegionAdjacencyGraph::Region &a, const RegionAdjacencyGraph::Region &b,
+                      const RegionAdjacencyGraph::Boundary &) const {
+        double dr = a.mean_r() - b.mean_r();
+        double dg = a.mean_g() - b.mean_g();
+        double db = a.mean_b() - b.mean_b();
+        return std::sqrt(dr * dr + dg * dg + db * db);
+    }
+};
+
+// Mean pixel metric along the boundary
+struct MeanBoundary {
+    double operator()(const RegionAdjacencyGraph::Region &, const RegionAdjacencyGraph::Region &,
+                      const RegionAdjacencyGraph::Boundary &e) const {
+        return e.mean_weight();
+    }
+};
+
+// Only pairs with a region smaller than min_size, ranked by Inner
+// (Felzenszwalb's min_size post-processing)
+template <typename Inner = MeanColor>
+struct SmallRegions {
+    int min_size;
+    Inner inner{};
+
+    double operator()(const RegionAdjacencyGraph::Region &a, const RegionAdjacencyGraph::Region &b,
+                      const RegionAdjacencyGraph::Boundary &e) const {
+        if (std::min(a.size, b.size) >= min_size) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return inner(a, b, e);
+    }
+};
+
+}
+
+#endif
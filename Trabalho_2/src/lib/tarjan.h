@@ -2,10 +2,10 @@
 #define TARJAN_ARBORESCENCE_H
 
 #include "arborescence.h"
+#include "verifier.h"
 #include <algorithm>
 #include <limits>
 #include <vector>
-#include <stack>
 
 class TarjanArborescence {
 private:
@@ -64,13 +64,12 @@ private:
         for (int v = 0; v < n; ++v) {
             if (v == root) continue;
             
-            auto sources = graph.get_sources_to(v);
-            for (const auto &[u, cost] : sources) {
+            graph.for_each_source(v, [&](int u, double cost) {
                 if (cost < min_costs[v]) {
                     min_costs[v] = cost;
                     min_edges[v] = DirectedEdge(u, v, cost);
                 }
-            }
+            });
         }
         return min_edges;
     }
@@ -165,7 +164,7 @@ private:
         }
 
         // Verificar se temos uma arborescência válida
-        if (is_valid_arborescence(parent, root)) {
+        if (ArborescenceVerifier::is_arborescence(parent, root)) {
             result.parent_of = parent;
             result.edge_costs = cost;
             result.total_tree_cost = total_cost;
@@ -179,46 +178,15 @@ private:
         double min_cost = INF;
         DirectedEdge best_edge;
         
-        auto sources = graph.get_sources_to(target);
-        for (const auto &[u, cost] : sources) {
+        graph.for_each_source(target, [&](int u, double cost) {
             if (u != exclude_source && u != target && u != root && cost < min_cost) {
                 min_cost = cost;
                 best_edge = DirectedEdge(u, target, cost);
             }
-        }
+        });
         
         return best_edge;
     }
-
-    bool is_valid_arborescence(const std::vector<int> &parent, int root) {
-        int n = parent.size();
-        std::vector<bool> visited(n, false);
-        std::stack<int> stack;
-        
-        stack.push(root);
-        visited[root] = true;
-        
-        while (!stack.empty()) {
-            int u = stack.top();
-            stack.pop();
-            
-            for (int v = 0; v < n; ++v) {
-                if (parent[v] == u && !visited[v]) {
-                    visited[v] = true;
-                    stack.push(v);
-                }
-            }
-        }
-        
-        // Verificar se todos os vértices são alcançáveis da raiz
-        for (int i = 0; i < n; ++i) {
-            if (i != root && !visited[i]) {
-                return false;
-            }
-        }
-        
-        return true;
-    }
 };
 
 #endif
\ No newline at end of file
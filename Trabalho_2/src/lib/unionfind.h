@@ -0,0 +1,87 @@
+#ifndef UNIONFIND_H
+#define UNIONFIND_H
+
+#include <algorithm>
+#include <vector>
+
+// Union-Find com o critério de Felzenszwalb (tamanho + custo interno por componente)
+struct SegmentUnionFind {
+    std::vector<int> parent;
+    std::vector<int> size;
+    std::vector<double> internal_cost; // Custo interno máximo da componente
+
+    SegmentUnionFind(int n = 0) {
+        reset(n);
+    }
+
+    // Reinicia para n vértices reaproveitando a memória já alocada
+    void reset(int n) {
+        parent.resize(n);
+        size.assign(n, 1);
+        internal_cost.assign(n, 0.0);
+        for (int i = 0; i < n; i++) {
+            parent[i] = i;
+        }
+    }
+
+    int find(int x) {
+        int root = x;
+        while (parent[root] != root) {
+            root = parent[root];
+        }
+        while (parent[x] != root) {
+            int next = parent[x];
+            parent[x] = root;
+            x = next;
+        }
+        return root;
+    }
+
+    bool join(int u, int v, double edge_weight, double k) {
+        int root_u = find(u);
+        int root_v = find(v);
+
+        if (root_u == root_v) {
+            return false;
+        }
+
+        // Limiar Felzenszwalb: MInt(C1,C2) = min(Int(C1)+k/|C1|, Int(C2)+k/|C2|)
+        double threshold_u = internal_cost[root_u] + k / size[root_u];
+        double threshold_v = internal_cost[root_v] + k / size[root_v];
+        double threshold = std::min(threshold_u, threshold_v);
+
+        // Funde apenas se a diferença for pequena o suficiente
+        if (edge_weight <= threshold) {
+            // Une os conjuntos
+            if (size[root_u] < size[root_v]) {
+                parent[root_u] = root_v;
+                size[root_v] += size[root_u];
+                // Distância interna é o peso da aresta de fusão
+                internal_cost[root_v] = edge_weight;
+            } else {
+                parent[root_v] = root_u;
+                size[root_u] += size[root_v];
+                internal_cost[root_u] = edge_weight;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void force_merge(int u, int v, double weight_hint) {
+        int root_u = find(u);
+        int root_v = find(v);
+        if (root_u == root_v) {
+            return;
+        }
+        if (size[root_u] < size[root_v]) {
+            std::swap(root_u, root_v);
+        }
+        parent[root_v] = root_u;
+        size[root_u] += size[root_v];
+        // Mantém o maior custo interno das duas componentes
+        internal_cost[root_u] = std::max(internal_cost[root_u], internal_cost[root_v]);
+    }
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef ARBORESCENCE_VERIFIER_H
+#define ARBORESCENCE_VERIFIER_H
+
+#include "arborescence.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+// Verificação de arborescências em O(n + m)
+//
+// is_arborescence: todo vértice fora a raiz tem um pai e chega à raiz (índice Euler, O(n)).
+// is_valid: além disso, as arestas existem no grafo com os custos registrados.
+// certifies_minimum: certificado dual do LP de Edmonds (ArborescenceDuals). A árvore é
+// mínima se (1) nenhuma aresta tem custo reduzido negativo, (2) as arestas da árvore
+// têm custo reduzido zero e (3) cada conjunto não unitário com y > 0 recebe exatamente
+// uma aresta da árvore. O custo reduzido de u -> v é c - soma de y dos conjuntos que
+// contêm v e não u, isto é, do caminho de v até o LCA(u, v) na floresta laminar;
+// os LCAs saem todos de uma vez (Tarjan offline), O((n + m) α(n)).
+// Serve para qualquer árvore com os mesmos custos, não só a que gerou os duais.
+class ArborescenceVerifier {
+
+public:
+
+    static bool is_arborescence(const std::vector<int>& parent, int root) {
+        int n = parent.size();
+        if (root < 0 || root >= n || parent[root] != -1) {
+            return false;
+        }
+        for (int v = 0; v < n; ++v) {
+            if (v != root && (parent[v] < 0 || parent[v] >= n || parent[v] == v)) {
+                return false;
+            }
+        }
+        return ArborescenceIndex::build(parent, root).subtree_size[root] == n;
+    }
+
+    static bool is_valid(const DirectedGraph& graph, const ArborescenceResult& result, double tolerance = 1e-9) {
+        int n = graph.vertex_count();
+        if (!result.is_complete || (int)result.parent_of.size() != n ||
+            !is_arborescence(result.parent_of, result.root_vertex)) {
+            return false;
+        }
+        double total = 0.0;
+        for (int v = 0; v < n; ++v) {
+            if (v == result.root_vertex) continue;
+            int u = result.parent_of[v];
+            if (!graph.has_connection(u, v) || !close(graph.connection_cost(u, v), result.edge_costs[v], tolerance)) {
+                return false;
+            }
+            total += result.edge_costs[v];
+        }
+        return close(total, result.total_tree_cost, tolerance * std::max(1.0, (double)n));
+    }
+
+    static bool certifies_minimum(const DirectedGraph& graph, const ArborescenceResult& result,
+                                  const ArborescenceDuals& duals, double tolerance = 1e-9) {
+        int n = graph.vertex_count();
+        int nodes = duals.value.size();
+        int root = result.root_vertex;
+        if (!is_valid(graph, result, tolerance) || nodes < n || (int)duals.cluster_parent.size() != nodes) {
+            return false;
+        }
+
+        // Floresta laminar: pai sempre com id maior, raiz sozinha, y >= 0 fora dos unitários
+        for (int x = 0; x < nodes; ++x) {
+            int p = duals.cluster_parent[x];
+            if (p != -1 && (p <= x || p >= nodes || p < n)) return false;
+            if (x >= n && duals.value[x] < -tolerance) return false;
+        }
+        if (duals.cluster_parent[root] != -1 || duals.value[root] != 0.0) {
+            return false;
+        }
+
+        // Y(x) = soma de y de x até o topo
+        std::vector<double> prefix(nodes);
+        for (int x = nodes - 1; x >= 0; --x) {
+            int p = duals.cluster_parent[x];
+            prefix[x] = duals.value[x] + (p == -1 ? 0.0 : prefix[p]);
+        }
+
+        // Consultas: todas as arestas do grafo e as da árvore (u == v e arestas para a raiz não contam)
+        std::vector<DirectedEdge> queries = graph.get_all_connections();
+        queries.erase(std::remove_if(queries.begin(), queries.end(), [&](const DirectedEdge& e) {
+            return e.source == e.target || e.target == root;
+        }), queries.end());
+        int graph_queries = queries.size();
+        for (int v = 0; v < n; ++v) {
+            if (v != root) queries.emplace_back(result.parent_of[v], v, result.edge_costs[v]);
+        }
+        std::vector<int> lca = offline_lca(duals.cluster_parent, n, queries);
+
+        auto entering = [&](int q) {
+            int a = lca[q];
+            return prefix[queries[q].target] - (a == -1 ? 0.0 : prefix[a]);
+        };
+        for (int q = 0; q < (int)queries.size(); ++q) {
+            double reduced = queries[q].cost - entering(q);
+            double scale = tolerance * std::max({1.0, std::abs(queries[q].cost), std::abs(entering(q))});
+            if (reduced < -scale) return false;
+            if (q >= graph_queries && reduced > scale) return false;
+        }
+
+        // Arestas da árvore entrando em cada nó: +1 no alvo, -1 no LCA, somado de baixo para cima
+        std::vector<int> entries(nodes, 0);
+        for (int q = graph_queries; q < (int)queries.size(); ++q) {
+            entries[queries[q].target]++;
+            if (lca[q] != -1) entries[lca[q]]--;
+        }
+        for (int x = 0; x < nodes; ++x) {
+            int p = duals.cluster_parent[x];
+            if (p != -1) entries[p] += entries[x];
+            if (x >= n && duals.value[x] > tolerance && entries[x] != 1) return false;
+        }
+        return true;
+    }
+
+private:
+
+    static bool close(double a, double b, double tolerance) {
+        return std::abs(a - b) <= tolerance * std::max({1.0, std::abs(a), std::abs(b)});
+    }
+
+    // LCA na floresta laminar de cada par (source, target) de folhas; -1 se em árvores diferentes
+    static std::vector<int> offline_lca(const std::vector<int>& cluster_parent, int n,
+                                        const std::vector<DirectedEdge>& queries) {
+        int nodes = cluster_parent.size();
+        int q_count = queries.size();
+
+        // Consultas de cada folha (CSR): 2q pelo alvo, 2q + 1 pela origem
+        std::vector<int> q_offset(n + 1, 0);
+        for (const DirectedEdge& e : queries) {
+            q_offset[e.source + 1]++;
+            q_offset[e.target + 1]++;
+        }
+        for (int v = 0; v < n; ++v) q_offset[v + 1] += q_offset[v];
+        std::vector<int> q_list(q_offset[n]);
+        std::vector<int> next(q_offset.begin(), q_offset.end() - 1);
+        for (int q = 0; q < q_count; ++q) {
+            q_list[next[queries[q].source]++] = 2 * q + 1;
+            q_list[next[queries[q].target]++] = 2 * q;
+        }
+
+        ArborescenceIndex tree = ArborescenceIndex::build(cluster_parent, -1);
+        std::vector<int> uf(nodes);
+        std::iota(uf.begin(), uf.end(), 0);
+        std::vector<int> ancestor(nodes);
+        std::vector<int> top(nodes, -1);
+        std::vector<char> done(n, 0);
+        auto find = [&](int x) {
+            while (uf[x] != x) {
+                uf[x] = uf[uf[x]];
+                x = uf[x];
+            }
+            return x;
+        };
+
+        std::vector<int> lca(q_count, -1);
+        // Pós-ordem da floresta: cada nó é unido ao pai depois de toda a sua subárvore
+        std::vector<int> by_post(nodes);
+        for (int x = 0; x < nodes; ++x) by_post[tree.post[x]] = x;
+        for (int x : tree.order) {
+            int p = cluster_parent[x];
+            top[x] = p == -1 ? x : top[p];
+        }
+        for (int x : by_post) {
+            ancestor[x] = x;
+            if (x < n) {
+                done[x] = 1;
+                for (int i = q_offset[x]; i < q_offset[x + 1]; ++i) {
+                    int q = q_list[i] / 2;
+                    int other = (q_list[i] & 1) ? queries[q].target : queries[q].source;
+                    if (!done[other]) continue;
+                    lca[q] = top[other] == top[x] ? ancestor[find(other)] : -1;
+                }
+            }
+            int p = cluster_parent[x];
+            if (p != -1) {
+                uf[find(x)] = find(p);
+                ancestor[find(p)] = p;
+            }
+        }
+        return lca;
+    }
+};
+
+#endif
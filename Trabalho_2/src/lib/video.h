@@ -0,0 +1,235 @@
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include "batch.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+// Frame-to-frame segmentation of a video
+//
+// The grid graph (4 forward edges per pixel, same weights as batch) is kept from
+// one frame to the next. A pixel counts as changed when its blurred color or its
+// gradient moved by more than `threshold` (0-255 scale) since its edge weights were
+// last computed, so a slow drift adds up until it crosses the threshold instead of
+// going unnoticed frame after frame. Only the edges touching changed pixels get new
+// weights and are re-sorted, then merged into the order
+// kept from the previous frame. The union-find starts with the previous segments
+// already joined over unchanged pixels, so static areas keep their labels and
+// only the edges around changes decide anything new.
+// When more than full_fraction of the pixels change (or the size changes), the
+// frame is segmented from scratch.
+class VideoSegmenter {
+
+private:
+
+    SegmentationParams params;
+    int threshold;
+    double full_fraction;
+
+    SegmentationWorkspace ws;
+    FeaturePlanes reference;          // Features each pixel's edge weights were computed from
+    int width = 0;
+    int height = 0;
+
+    // Edge 4 * p + d goes from pixel p to its neighbour in direction d (see neighbour())
+    std::vector<double> weight;
+    std::vector<char> valid;
+    std::vector<int> sorted;          // Valid edge ids by (weight, id)
+    std::vector<int> dirty;
+    std::vector<int> kept;
+    std::vector<char> is_dirty;
+
+    std::vector<char> changed;
+    std::vector<int> label;           // Segment root of every pixel in the previous frame
+    std::vector<double> internal;     // Int(C) by root pixel, previous frame
+
+    int changed_pixels = 0;
+    int recomputed_edges = 0;
+    bool full = true;
+
+    // Forward neighbours: down-left, down, down-right, right (-1 outside the image)
+    int neighbour(int p, int d) const {
+        int x = p % width, y = p / width;
+        switch (d) {
+            case 0: return (x > 0 && y < height - 1) ? p + width - 1 : -1;
+            case 1: return (y < height - 1) ? p + width : -1;
+            case 2: return (x < width - 1 && y < height - 1) ? p + width + 1 : -1;
+            default: return (x < width - 1) ? p + 1 : -1;
+        }
+    }
+
+    bool edge_less(int a, int b) const {
+        return weight[a] < weight[b] || (weight[a] == weight[b] && a < b);
+    }
+
+    void update_edge(int e, const pixel_metric::GradientBlended<> &metric) {
+        if (!valid[e] || is_dirty[e]) return;
+        weight[e] = ws.features.weight(e / 4, neighbour(e / 4, e % 4), metric);
+        is_dirty[e] = 1;
+        dirty.push_back(e);
+    }
+
+    void rebuild_graph(const pixel_metric::GradientBlended<> &metric) {
+        int n = width * height;
+        weight.assign(4 * n, 0.0);
+        valid.assign(4 * n, 0);
+        is_dirty.assign(4 * n, 0);
+        sorted.clear();
+        for (int p = 0; p < n; p++) {
+            for (int d = 0; d < 4; d++) {
+                int q = neighbour(p, d);
+                if (q == -1) continue;
+                int e = 4 * p + d;
+                valid[e] = 1;
+                weight[e] = ws.features.weight(p, q, metric);
+                sorted.push_back(e);
+            }
+        }
+        std::sort(sorted.begin(), sorted.end(), [&](int a, int b) { return edge_less(a, b); });
+        recomputed_edges = static_cast<int>(sorted.size());
+    }
+
+    // New weights for the edges of changed pixels, merged back into `sorted`
+    void update_graph(const pixel_metric::GradientBlended<> &metric) {
+        int n = width * height;
+        dirty.clear();
+        for (int p = 0; p < n; p++) {
+            if (!changed[p]) continue;
+            int x = p % width, y = p / width;
+            for (int d = 0; d < 4; d++) update_edge(4 * p + d, metric);
+            // Edges of the neighbours above and to the left that end at p
+            if (y > 0 && x < width - 1) update_edge(4 * (p - width + 1) + 0, metric);
+            if (y > 0) update_edge(4 * (p - width) + 1, metric);
+            if (y > 0 && x > 0) update_edge(4 * (p - width - 1) + 2, metric);
+            if (x > 0) update_edge(4 * (p - 1) + 3, metric);
+        }
+        std::sort(dirty.begin(), dirty.end(), [&](int a, int b) { return edge_less(a, b); });
+
+        kept.clear();
+        for (int e : sorted) {
+            if (!is_dirty[e]) kept.push_back(e);
+        }
+        sorted.resize(kept.size() + dirty.size());
+        std::merge(kept.begin(), kept.end(), dirty.begin(), dirty.end(), sorted.begin(),
+                   [&](int a, int b) { return edge_less(a, b); });
+        for (int e : dirty) is_dirty[e] = 0;
+        recomputed_edges = static_cast<int>(dirty.size());
+    }
+
+    void mark_changes() {
+        int n = width * height;
+        changed.assign(n, 0);
+        changed_pixels = 0;
+        const FeaturePlanes &now = ws.features;
+        for (int p = 0; p < n; p++) {
+            int color = std::max({std::abs(now.r[p] - reference.r[p]),
+                                  std::abs(now.g[p] - reference.g[p]),
+                                  std::abs(now.b[p] - reference.b[p])});
+            double gradient = std::abs(now.gradient[p] - reference.gradient[p]) * 255.0;
+            if (color > threshold || gradient > threshold) {
+                changed[p] = 1;
+                changed_pixels++;
+            }
+        }
+    }
+
+    // Changed pixels had all their edges recomputed from the current features
+    void update_reference() {
+        const FeaturePlanes &now = ws.features;
+        int n = width * height;
+        for (int p = 0; p < n; p++) {
+            if (!changed[p]) continue;
+            reference.r[p] = now.r[p];
+            reference.g[p] = now.g[p];
+            reference.b[p] = now.b[p];
+            reference.gradient[p] = now.gradient[p];
+        }
+    }
+
+    // Previous segments joined again over edges between unchanged pixels
+    void seed_union_find() {
+        SegmentUnionFind &uf = ws.uf;
+        for (int e : sorted) {
+            int p = e / 4, q = neighbour(p, e % 4);
+            if (!changed[p] && !changed[q] && label[p] == label[q]) {
+                uf.force_merge(p, q, 0.0);
+            }
+        }
+        int n = width * height;
+        for (int p = 0; p < n; p++) {
+            if (!changed[p] && uf.parent[p] == p) {
+                uf.internal_cost[p] = internal[label[p]];
+            }
+        }
+    }
+
+public:
+
+    VideoSegmenter(const SegmentationParams &params, int threshold, double full_fraction = 0.5)
+    : params(params), threshold(threshold), full_fraction(full_fraction) {}
+
+    // The caller reads each frame into workspace().image / width / height
+    SegmentationWorkspace& workspace() {
+        return ws;
+    }
+
+    // Segments the frame in workspace(); labels are left in workspace().uf
+    void segment() {
+        bool resized = ws.width != width || ws.height != height;
+        width = ws.width;
+        height = ws.height;
+        int n = width * height;
+
+        preprocess_image(ws, params);
+        sobelOperator(ws.gray_blurred, width, height, ws.sobel);
+        ws.features.assign(ws.color_blurred, ws.sobel, width, height);
+
+        pixel_metric::GradientBlended<> metric{params.color_scale, params.gradient_scale};
+        full = resized;
+        if (!full) {
+            mark_changes();
+            full = changed_pixels > full_fraction * n;
+        }
+        if (full) {
+            changed.assign(n, 1);
+            changed_pixels = n;
+            rebuild_graph(metric);
+            reference = ws.features;
+        }
+        else {
+            update_graph(metric);
+            update_reference();
+        }
+
+        ws.uf.reset(n);
+        if (!full) {
+            seed_union_find();
+        }
+        for (int e : sorted) {
+            int p = e / 4;
+            ws.uf.join(p, neighbour(p, e % 4), weight[e], params.k);
+        }
+
+        label.resize(n);
+        internal.assign(n, 0.0);
+        for (int p = 0; p < n; p++) {
+            label[p] = ws.uf.find(p);
+            if (label[p] == p) internal[p] = ws.uf.internal_cost[p];
+        }
+    }
+
+    int last_changed_pixels() const {
+        return changed_pixels;
+    }
+
+    int last_recomputed_edges() const {
+        return recomputed_edges;
+    }
+
+    bool last_was_full() const {
+        return full;
+    }
+};
+
+#endif
@@ -1,79 +1,27 @@
 #include "util/Ppm.h"
 #include "lib/felzenszwalb.h"
 #include "lib/edmonds.h"
-#include <ctime>
+#include "lib/branching.h"
+#include "lib/hierarchy.h"
+#include "lib/pyramid.h"
+#include "lib/rag.h"
+#include "util/AsyncWriter.h"
+#include "util/Pipeline.h"
+#include "util/StageCache.h"
+#include <cstring>
 #include <filesystem>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
 
-double getRuntime (clock_t start, clock_t end) {
-	return (((double)(end-start)/CLOCKS_PER_SEC));
-}
-
-int main (int argc, char *argv[]) {
-    clock_t start = clock();
-    int width, height;
-
-	if (!std::filesystem::exists("input.ppm")) {
-		std::cout << "No ppm input file detected!\nTo convert an image, run the code at [src/util/png_to_ppm.py] with a png file as a parameter.\n";
-		return 0;
-	}
-
-    std::vector<std::vector<std::vector<int>>> image; // estrutura para armazenar uma imagem representada por uma matriz tridimensional dinâmica
-    if (!loadPPM("./input.ppm", image, width, height)) {
-        std::cout<< "nao foi possivel abrir a imagem"<<std::endl;
-    }
-    auto original_image = image;
-    auto color_graph_input = original_image;
-
-    clock_t after_image_load = clock();
-
-    WeightedGraph G = WeightedGraph::from_ppm_matrix(original_image, width, height, 0.0);
-
-	clock_t after_initial_graph_created = clock();
-
-	grayscaleImg(image, width, height);
-    savePPM_matrix("grayscale.ppm", image, width, height);
-
-	clock_t after_grayscale = clock();
-
-    image = blurImg(image, width, height, 5);
-    color_graph_input = blurImg(color_graph_input, width, height, 3);
-    savePPM_matrix("blurred.ppm", image, width, height);
-	clock_t after_blur = clock();
-
-	std::vector<std::vector<std::vector<int>>> sobel = sobelOperator(image, width, height);
-    savePPM_matrix("sobel.ppm", sobel, width, height);
-	clock_t after_sobel = clock();
-
-    WeightedGraph S = WeightedGraph::from_color_and_gradient(
-        color_graph_input,
-        sobel,
-        width,
-        height,
-        1.1,
-        0.45
-    );
-    clock_t after_graph_from_matrix = clock();
-
-    WeightedGraph* T = kruskal_segmentation(G, &S, width, 1550);
-    auto t = T->to_ppm_matrix(width, height);
-    clock_t after_kruskal = clock();
-
-    savePPM_matrix("Felzenszwalb.ppm", t, width, height);
-    clock_t after_matrix_from_graph = clock();
-
-    DirectedGraph directed = DirectedGraph::from_weighted_graph(S);
-    EdmondsAlgorithm edmonds_algo;
-    ArborescenceResult edmonds_result = edmonds_algo.segment_image(directed, 300.0, 20);
-
-    // Recolor by component average for better visualization
+// Every segment (label = segment root) painted with its average color
+std::vector<std::vector<std::vector<int>>> averageSegments (const std::vector<int> &labels, const std::vector<RGB> &pixColors, int width, int height) {
     std::unordered_map<int, std::vector<int>> comps;
-    int nverts = directed.vertex_count();
+    int nverts = labels.size();
     for (int i = 0; i < nverts; ++i) {
-        int root = edmonds_result.parent_of[i];
-        comps[root].push_back(i);
+        comps[labels[i]].push_back(i);
     }
 
-    auto pixColors = G.getPixColor();
     std::unordered_map<int, RGB> avgColor;
     for (auto &kv : comps) {
         long long sr = 0, sg = 0, sb = 0;
@@ -93,30 +41,268 @@ int main (int argc, char *argv[]) {
         avgColor[kv.first] = c;
     }
 
-    std::vector<std::vector<std::vector<int>>> edmonds_avg(height, std::vector<std::vector<int>>(width, std::vector<int>(3)));
+    std::vector<std::vector<std::vector<int>>> avg(height, std::vector<std::vector<int>>(width, std::vector<int>(3)));
     for (int i = 0; i < nverts; ++i) {
-        int root = edmonds_result.parent_of[i];
-        RGB c = avgColor[root];
+        RGB c = avgColor[labels[i]];
         int x = i % width;
         int y = i / width;
-        edmonds_avg[y][x][0] = c.r;
-        edmonds_avg[y][x][1] = c.g;
-        edmonds_avg[y][x][2] = c.b;
+        avg[y][x][0] = c.r;
+        avg[y][x][1] = c.g;
+        avg[y][x][2] = c.b;
+    }
+    return avg;
+}
+
+// Every segment painted with the color of its root pixel
+std::vector<std::vector<std::vector<int>>> rootSegments (const std::vector<int> &roots, const std::vector<RGB> &pixColors, int width, int height) {
+    std::vector<std::vector<std::vector<int>>> painted(height, std::vector<std::vector<int>>(width, std::vector<int>(3)));
+    for (int i = 0; i < (int)roots.size(); ++i) {
+        RGB c = pixColors[roots[i]];
+        painted[i / width][i % width] = {c.r, c.g, c.b};
+    }
+    return painted;
+}
+
+std::vector<std::string> splitList (const char *list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+void printUsage (const Pipeline &pipeline) {
+    std::cout << "Usage: main [--stages s1,s2,...] [--skip s1,s2,...] [--save-intermediates]\n"
+              << "            [--sweep k1,k2,...] [--pyramid levels] [--min-size N] [--branching COST]\n"
+              << "            [--cache DIR] [--cache-size MB]\n"
+              << "  --stages              stages to run (their dependencies run too); default: felzenszwalb,edmonds\n"
+              << "  --skip                stages to leave out\n"
+              << "  --save-intermediates  also write grayscale.ppm, blurred.ppm and sobel.ppm\n"
+              << "  --sweep               one hierarchy, one segmentation per k (enables sweep)\n"
+              << "  --pyramid             coarse-to-fine segmentation (enables pyramid)\n"
+              << "  --min-size            merge Edmonds segments smaller than N pixels into Regions.ppm (enables regions)\n"
+              << "  --branching           minimum branching, COST = price of starting a segment (enables branching)\n"
+              << "  --cache               reuse blurred image, gradient and graph of a previous run (enables cache)\n"
+              << "  --cache-size          cache size limit in MB, least recently used entries go first (default 512)\n"
+              << "Stages:";
+    for (const std::string &name : pipeline.names()) {
+        std::cout << " " << name;
+    }
+    std::cout << "\n";
+}
+
+int main (int argc, char *argv[]) {
+    int width = 0, height = 0;
+
+    std::vector<std::string> targets;
+    std::vector<std::string> skipped;
+    bool save_intermediates = false;
+    std::vector<double> sweep;
+    int pyramid_levels = 0;
+    int min_size = 0;
+    double branching_cost = 0.0;
+    std::string cache_dir;
+    uint64_t cache_megabytes = 512;
+    bool help = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--stages") == 0 && i + 1 < argc) {
+            for (const std::string &name : splitList(argv[++i])) targets.push_back(name);
+        } else if (std::strcmp(argv[i], "--skip") == 0 && i + 1 < argc) {
+            for (const std::string &name : splitList(argv[++i])) skipped.push_back(name);
+        } else if (std::strcmp(argv[i], "--save-intermediates") == 0) {
+            save_intermediates = true;
+        } else if (std::strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            for (const std::string &k : splitList(argv[++i])) sweep.push_back(std::atof(k.c_str()));
+            targets.push_back("sweep");
+        } else if (std::strcmp(argv[i], "--pyramid") == 0 && i + 1 < argc) {
+            pyramid_levels = std::max(1, std::atoi(argv[++i]));
+            targets.push_back("pyramid");
+        } else if (std::strcmp(argv[i], "--min-size") == 0 && i + 1 < argc) {
+            min_size = std::max(1, std::atoi(argv[++i]));
+            targets.push_back("regions");
+        } else if (std::strcmp(argv[i], "--branching") == 0 && i + 1 < argc) {
+            branching_cost = std::atof(argv[++i]);
+            targets.push_back("branching");
+        } else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+            cache_megabytes = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            help = true;
+        }
+    }
+    if (targets.empty()) {
+        targets = {"felzenszwalb", "edmonds"};
+    }
+
+    // Preprocessing parameters (part of the cache key)
+    const int gray_blur_passes = 5;
+    const int color_blur_passes = 3;
+    const double color_scale = 1.1;
+    const double gradient_scale = 0.45;
+
+    // Outputs are written on a background thread while the next stages run
+    AsyncWriter writer;
+
+    std::vector<std::vector<std::vector<int>>> image; // estrutura para armazenar uma imagem representada por uma matriz tridimensional dinâmica
+    std::vector<std::vector<std::vector<int>>> gray;
+    std::vector<std::vector<std::vector<int>>> gray_blurred;
+    std::vector<std::vector<std::vector<int>>> color_blurred;
+    std::vector<std::vector<std::vector<int>>> sobel;
+    std::vector<std::vector<std::vector<int>>> scratch;
+    std::vector<RGB> colors;
+    ImageGraph S(0);
+    std::optional<MappedGraph> cached_graph;    // On a cache hit, used in place of S
+    std::string cache_key;
+    ArborescenceResult edmonds_result(0, -1);
+
+    Pipeline pipeline;
+    pipeline.add("load", {}, [&]() {
+        if (!loadPPM("./input.ppm", image, width, height)) {
+            throw std::runtime_error("nao foi possivel abrir a imagem");
+        }
+    });
+    // Input pixel colors, for painting segments (no graph needed)
+    pipeline.add("colors", {"load"}, [&]() {
+        colors.resize(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                colors[y * width + x] = RGB(image[y][x][0], image[y][x][1], image[y][x][2]);
+            }
+        }
+    });
+    // A hit restores blurred color image and gradient, maps the graph file (the segmenters
+    // read its CSR as is), and preprocessing is skipped
+    pipeline.add("cache", {"load"}, [&]() {
+        std::stringstream params;
+        params << "v1 gray_blur=" << gray_blur_passes << " color_blur=" << color_blur_passes
+               << " color_scale=" << color_scale << " gradient_scale=" << gradient_scale;
+        cache_key = StageCache::make_key(StageCache::read_bytes("input.ppm"), params.str());
+        StageCache cache(cache_dir, cache_megabytes << 20);
+        std::filesystem::path entry = cache.find(cache_key);
+        if (entry.empty() ||
+            !StageCache::read_image(entry / "blurred.bin", color_blurred, width, height) ||
+            !StageCache::read_image(entry / "gradient.bin", sobel, width, height)) {
+            return;
+        }
+        try {
+            cached_graph.emplace(ImageGraph::open_mapped((entry / "graph.bin").string()));
+        } catch (const std::runtime_error &) {
+            return;
+        }
+        for (const char *name : {"grayscale", "blur", "sobel", "graph", "cache_store"}) {
+            pipeline.skip(name);
+        }
+    });
+    pipeline.add("grayscale", {"load"}, [&]() {
+        gray = image;
+        grayscaleImg(gray, width, height);
+        if (save_intermediates) writer.save("grayscale.ppm", gray, width, height);
+    });
+    pipeline.add("blur", {"grayscale"}, [&]() {
+        blurImg(gray, width, height, gray_blur_passes, gray_blurred, scratch);
+        blurImg(image, width, height, color_blur_passes, color_blurred, scratch);
+        if (save_intermediates) writer.save("blurred.ppm", gray_blurred, width, height);
+    });
+    pipeline.add("sobel", {"blur"}, [&]() {
+        sobelOperator(gray_blurred, width, height, sobel);
+        if (save_intermediates) writer.save("sobel.ppm", sobel, width, height);
+    });
+    pipeline.add("graph", {"sobel"}, [&]() {
+        S = ImageGraph::from_color_and_gradient(color_blurred, sobel, width, height, color_scale, gradient_scale);
+    });
+    pipeline.add("cache_store", {"cache", "graph"}, [&]() {
+        StageCache cache(cache_dir, cache_megabytes << 20);
+        std::filesystem::path staging = cache.prepare(cache_key);
+        if (StageCache::write_image(staging / "blurred.bin", color_blurred, width, height, 3) &&
+            StageCache::write_image(staging / "gradient.bin", sobel, width, height, 1) &&
+            S.save_binary((staging / "graph.bin").string())) {
+            cache.publish(cache_key);
+        }
+    });
+    auto directed_graph = [&]() {
+        return cached_graph ? DirectedGraph::from_mapped(*cached_graph) : DirectedGraph::from_weighted_graph(S);
+    };
+    pipeline.add("felzenszwalb", {"colors", "graph"}, [&]() {
+        std::vector<int> roots = cached_graph ? kruskal_segments(kruskal_edges(*cached_graph, width), width * height, 1550)
+                                              : kruskal_segments(kruskal_edges(S, width), width * height, 1550);
+        writer.save("Felzenszwalb.ppm", rootSegments(roots, colors, width, height), width, height);
+    });
+    pipeline.add("edmonds", {"colors", "graph"}, [&]() {
+        DirectedGraph directed = directed_graph();
+        EdmondsAlgorithm edmonds_algo;
+        edmonds_result = edmonds_algo.segment_image(directed, 300.0, 20);
+        // Recolor by component average for better visualization
+        writer.save("Edmonds.ppm", averageSegments(edmonds_result.parent_of, colors, width, height), width, height);
+    });
+    // Region adjacency graph of the Edmonds segments, small regions merged into their closest neighbour
+    pipeline.add("regions", {"edmonds", "colors"}, [&]() {
+        FeaturePlanes planes = FeaturePlanes::from_images(color_blurred, sobel, width, height);
+        RegionAdjacencyGraph rag = RegionAdjacencyGraph::from_labels(
+            edmonds_result.parent_of, planes, pixel_metric::GradientBlended<>{color_scale, gradient_scale});
+        int before = rag.region_count();
+        rag.merge(region_merge::SmallRegions<>{std::max(1, min_size)});
+        printf("Regions: %d -> %d (min size %d)\n", before, rag.region_count(), min_size);
+        writer.save("Regions.ppm", averageSegments(rag.labels(), colors, width, height), width, height);
+    });
+    // Minimum spanning forest of the directed graph: a virtual root reaches every pixel at branching_cost
+    pipeline.add("branching", {"colors", "graph"}, [&]() {
+        DirectedGraph directed = directed_graph();
+        MinimumBranching branching;
+        ArborescenceResult segments = branching.segment_image(directed, branching_cost);
+        int count = 0;
+        for (int v = 0; v < (int)segments.parent_of.size(); v++) {
+            count += segments.parent_of[v] == v;
+        }
+        printf("Branching: %d segments (cost %g)\n", count, branching_cost);
+        writer.save("Branching.ppm", averageSegments(segments.parent_of, colors, width, height), width, height);
+    });
+    pipeline.add("sweep", {"colors", "graph"}, [&]() {
+        SegmentationHierarchy hierarchy = cached_graph ? SegmentationHierarchy::from_mapped(*cached_graph)
+                                                       : SegmentationHierarchy::from_weighted_graph(S);
+        for (double k : sweep.empty() ? std::vector<double>{300.0} : sweep) {
+            std::stringstream name;
+            name << "Felzenszwalb_k" << k << ".ppm";
+            writer.save(name.str(), averageSegments(hierarchy.labels_for(k), colors, width, height), width, height);
+            printf("k = %g: %d segments\n", k, hierarchy.segment_count(k));
+        }
+    });
+    pipeline.add("pyramid", {"colors", "sobel"}, [&]() {
+        PyramidSegmentation pyramid(color_scale, gradient_scale, 300.0, std::max(1, pyramid_levels));
+        ArborescenceResult segments = pyramid.segment(color_blurred, sobel, width, height);
+        writer.save("Pyramid.ppm", averageSegments(segments.parent_of, colors, width, height), width, height);
+        printf("Refined pixels: %lld of %d\n", pyramid.last_refined_pixels(), width * height);
+    });
+
+    if (help) {
+        printUsage(pipeline);
+        return 0;
+    }
+
+	if (!std::filesystem::exists("input.ppm")) {
+		std::cout << "No ppm input file detected!\nTo convert an image, run the code at [src/util/png_to_ppm.py] with a png file as a parameter.\n";
+		return 0;
+	}
+
+    try {
+        for (const std::string &name : targets) pipeline.enable(name);
+        if (!cache_dir.empty()) {
+            pipeline.enable("cache");
+            pipeline.enable("cache_store");
+        }
+        for (const std::string &name : skipped) pipeline.disable(name);
+        pipeline.run();
+    } catch (const std::exception &e) {
+        std::cout << e.what() << std::endl;
+        printUsage(pipeline);
+        return 1;
     }
-    savePPM_matrix("Edmonds.ppm", edmonds_avg, width, height);
+    writer.finish();
 
-    clock_t finish = clock();
     printf("Execution time --\n\n");
-	printf("Matrix from image: %lf\n", getRuntime(start, after_image_load));
-	printf("Original graph from matrix: %lf\n", getRuntime(after_image_load, after_initial_graph_created));
-	printf("Preprocessing:\n-> Grayscale: %lf\n", getRuntime(after_initial_graph_created, after_grayscale));
-	printf("-> Gaussian: %lf\n", getRuntime(after_grayscale, after_blur));
-	printf("-> Sobel: %lf\n", getRuntime(after_blur, after_sobel));
-	printf("Preprocessed graph from matrix: %lf\n", getRuntime(after_sobel, after_graph_from_matrix));
-	printf("Felzenszwalb: %lf\n", getRuntime(after_graph_from_matrix, after_kruskal));
-	printf("Matrix from graph: %lf\n", getRuntime(after_kruskal, after_matrix_from_graph));
-    printf("Edmonds: %lf\n", getRuntime(after_matrix_from_graph, finish));
-    printf("Total runtime: %lf\n", getRuntime(start, finish));
+    pipeline.print_timings();
 
     return 0;
 }
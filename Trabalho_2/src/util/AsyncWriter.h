@@ -0,0 +1,80 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include "Ppm.h"
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes PPM files on a background thread so disk I/O overlaps with computation
+// save() takes ownership of the image (move it in, or pass a copy)
+class AsyncWriter {
+
+private:
+
+    struct Job {
+        std::string filename;
+        std::vector<std::vector<std::vector<int>>> image;
+        int width;
+        int height;
+    };
+
+    std::queue<Job> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread worker;
+
+    void worker_loop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop();
+            }
+            savePPM_matrix(job.filename, job.image, job.width, job.height);
+        }
+    }
+
+public:
+
+    AsyncWriter()
+    : stopping(false), worker([this] { worker_loop(); }) {}
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator= (const AsyncWriter&) = delete;
+
+    ~AsyncWriter() {
+        finish();
+    }
+
+    void save(std::string filename, std::vector<std::vector<std::vector<int>>> image, int width, int height) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push(Job{std::move(filename), std::move(image), width, height});
+        }
+        wake.notify_one();
+    }
+
+    // Blocks until every queued file is on disk
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+};
+
+#endif
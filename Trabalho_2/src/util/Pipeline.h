@@ -0,0 +1,126 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Declarative stage graph
+// Stages are registered after their dependencies; run() executes every enabled
+// stage plus whatever it depends on, in registration order, and times each one
+class Pipeline {
+
+private:
+
+    struct Stage {
+        std::string name;
+        std::vector<std::string> deps;
+        std::function<void()> run;
+        bool requested = false;     // Enabled from the CLI (or by default)
+        bool disabled = false;      // Explicitly turned off
+        bool needed = false;        // Requested or required by a requested stage
+        bool skipped = false;       // Result provided some other way (e.g. a cache) during run()
+        double seconds = 0.0;
+    };
+
+    std::vector<Stage> stages;
+
+    int index_of(const std::string &name) const {
+        for (int i = 0; i < (int)stages.size(); i++) {
+            if (stages[i].name == name) return i;
+        }
+        return -1;
+    }
+
+    Stage& at(const std::string &name) {
+        int i = index_of(name);
+        if (i == -1) {
+            throw std::invalid_argument("Unknown stage: " + name);
+        }
+        return stages[i];
+    }
+
+    void require(int i, const std::string &by) {
+        Stage &stage = stages[i];
+        if (stage.disabled) {
+            throw std::invalid_argument("Stage " + stage.name + " is disabled but " + by + " needs it");
+        }
+        if (stage.needed) return;
+        stage.needed = true;
+        for (const std::string &dep : stage.deps) {
+            require(index_of(dep), stage.name);
+        }
+    }
+
+public:
+
+    void add(const std::string &name, std::vector<std::string> deps, std::function<void()> run) {
+        for (const std::string &dep : deps) {
+            if (index_of(dep) == -1) {
+                throw std::invalid_argument("Stage " + name + " depends on unknown stage " + dep);
+            }
+        }
+        stages.push_back(Stage{name, std::move(deps), std::move(run)});
+    }
+
+    bool has(const std::string &name) const {
+        return index_of(name) != -1;
+    }
+
+    void enable(const std::string &name) {
+        at(name).requested = true;
+    }
+
+    void disable(const std::string &name) {
+        Stage &stage = at(name);
+        stage.disabled = true;
+        stage.requested = false;
+    }
+
+    // Called from a running stage: `name` has not run yet and will not run
+    void skip(const std::string &name) {
+        at(name).skipped = true;
+    }
+
+    // Names of the stages in registration order
+    std::vector<std::string> names() const {
+        std::vector<std::string> res;
+        for (const Stage &stage : stages) res.push_back(stage.name);
+        return res;
+    }
+
+    void run() {
+        for (Stage &stage : stages) {
+            stage.needed = false;
+            stage.skipped = false;
+        }
+        for (int i = 0; i < (int)stages.size(); i++) {
+            if (stages[i].requested) require(i, stages[i].name);
+        }
+        for (Stage &stage : stages) {
+            if (!stage.needed || stage.skipped) continue;
+            auto start = std::chrono::steady_clock::now();
+            stage.run();
+            stage.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    void print_timings() const {
+        double total = 0.0;
+        for (const Stage &stage : stages) {
+            if (!stage.needed) continue;
+            if (stage.skipped) {
+                printf("%s: skipped\n", stage.name.c_str());
+                continue;
+            }
+            printf("%s: %lf\n", stage.name.c_str(), stage.seconds);
+            total += stage.seconds;
+        }
+        printf("Total runtime: %lf\n", total);
+    }
+};
+
+#endif
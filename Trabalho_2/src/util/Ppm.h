@@ -1,3 +1,6 @@
+#ifndef PPM_H
+#define PPM_H
+
 #include <iostream>
 #include <vector>
 #include <algorithm>
@@ -9,20 +12,28 @@
 #include <stdint.h>
 #include "../graph/edge.h"
 
-bool loadPPM(
-    const std::string &filename, 
+// Gives img the shape [height][width][3], reusing the memory it already has
+void reshapeImage(std::vector<std::vector<std::vector<int>>> &img, int width, int height) {
+    img.resize(height);
+    for (auto &row : img) {
+        row.resize(width);
+        for (auto &pixel : row) {
+            pixel.resize(3);
+        }
+    }
+}
+
+// Reads the next P6 image of the stream (several can be concatenated);
+// false without a message at the end of the stream
+bool readPPM(
+    std::istream &file,
     std::vector<std::vector<std::vector<int>>> &image, 
     int &width, int &height
 ) {
-    
-    std::ifstream file(filename, std::ios::binary); 
-    if (!file.is_open()) {
-        std::cerr << "ERRO ao abrir o arquivo PPM." << std::endl;
+    std::string header;
+    if (!(file >> header)) {
         return false;
     }
-
-    std::string header;
-    file >> header;
     if (header != "P6") {
         std::cerr << "ERRO: Formato PPM esperado: P6." << std::endl;
         return false;
@@ -47,32 +58,44 @@ bool loadPPM(
     }
 
     // [height][widht][rgb[3]]
-    image.resize(height, std::vector<std::vector<int>>(width, std::vector<int>(3)));
+    reshapeImage(image, width, height);
 
-    // Para cada pixel armazena os dados sobre o rgb dele
+    // Para cada pixel armazena os dados sobre o rgb dele (uma linha por leitura)
+    std::vector<unsigned char> row(width * 3);
     for (int y = 0; y < height; y++) {
+        if (!file.read(reinterpret_cast<char *>(row.data()), width * 3)) {
+            std::cerr << "Erro ao ler dados RGB do arquivo PPM." << std::endl;
+            return false;
+        }
         for (int x = 0; x < width; x++) {
-            unsigned char rgb[3];
-            if (!file.read(reinterpret_cast<char *>(rgb), 3)) {
-                std::cerr << "Erro ao ler dados RGB do arquivo PPM." << std::endl;
-                return false;
-            }
-            image[y][x][0] = rgb[0];
-            image[y][x][1] = rgb[1];
-            image[y][x][2] = rgb[2];
+            image[y][x][0] = row[3 * x];
+            image[y][x][1] = row[3 * x + 1];
+            image[y][x][2] = row[3 * x + 2];
         }
     }
 
     return true;
 }
 
-void savePPM_matrix(
+bool loadPPM(
     const std::string &filename, 
+    std::vector<std::vector<std::vector<int>>> &image, 
+    int &width, int &height
+) {
+    
+    std::ifstream file(filename, std::ios::binary); 
+    if (!file.is_open()) {
+        std::cerr << "ERRO ao abrir o arquivo PPM." << std::endl;
+        return false;
+    }
+    return readPPM(file, image, width, height);
+}
+
+void writePPM(
+    std::ostream &file,
     const std::vector<std::vector<std::vector<int>>> &image,
     int width, int height
 ) {
-    std::ofstream file(filename, std::ios::binary);
-    
     file << "P6\n";
     // file << "# Segmented Image\n";
     file << width << " " << height << "\n";
@@ -88,9 +111,17 @@ void savePPM_matrix(
     }
 }
 
-std::vector<std::vector<std::vector<int>>> sobelOperator(std::vector<std::vector<std::vector<int>>> &img, int width, int height){
-    std::vector<std::vector<std::vector<int>>> res;
-    res.resize(height, std::vector<std::vector<int>>(width, std::vector<int>(3)));
+void savePPM_matrix(
+    const std::string &filename, 
+    const std::vector<std::vector<std::vector<int>>> &image,
+    int width, int height
+) {
+    std::ofstream file(filename, std::ios::binary);
+    writePPM(file, image, width, height);
+}
+
+void sobelOperator(const std::vector<std::vector<std::vector<int>>> &img, int width, int height, std::vector<std::vector<std::vector<int>>> &res){
+    reshapeImage(res, width, height);
     for(int y=0; y<height; y++){
         for(int x=0; x<width; x++){
             bool left = x < 1,
@@ -147,15 +178,19 @@ std::vector<std::vector<std::vector<int>>> sobelOperator(std::vector<std::vector
 			// Use a single color since all colors should have the same value
 			// because of the grayscaling
 			int G = std::sqrt(nrx * nrx + nry * nry);
-            res[y][x] = {G, G, G};
+            res[y][x][0] = res[y][x][1] = res[y][x][2] = G;
         }
     }
-    return res;
 }
 
-std::vector<std::vector<std::vector<int>>> gaussianBlur (std::vector<std::vector<std::vector<int>>> &img, int width, int height){
+std::vector<std::vector<std::vector<int>>> sobelOperator(std::vector<std::vector<std::vector<int>>> &img, int width, int height){
     std::vector<std::vector<std::vector<int>>> res;
-    res.resize(height, std::vector<std::vector<int>>(width, std::vector<int>(3)));
+    sobelOperator(img, width, height, res);
+    return res;
+}
+
+void gaussianBlur (const std::vector<std::vector<std::vector<int>>> &img, int width, int height, std::vector<std::vector<std::vector<int>>> &res){
+    reshapeImage(res, width, height);
     for(int y=0; y<height; y++){
         for(int x=0; x<width; x++){
             bool left = x < 1,
@@ -240,9 +275,16 @@ std::vector<std::vector<std::vector<int>>> gaussianBlur (std::vector<std::vector
             nr /= 16;
             ng /= 16;
             nb /= 16;
-            res[y][x] = {nr, ng, nb};
+            res[y][x][0] = nr;
+            res[y][x][1] = ng;
+            res[y][x][2] = nb;
         }
     }
+}
+
+std::vector<std::vector<std::vector<int>>> gaussianBlur (std::vector<std::vector<std::vector<int>>> &img, int width, int height){
+    std::vector<std::vector<std::vector<int>>> res;
+    gaussianBlur(img, width, height, res);
     return res;
 }
 
@@ -280,3 +322,30 @@ std::vector<std::vector<std::vector<int>>> blurImg (std::vector<std::vector<std:
     }
     return blurred;
 }
+
+// Same as above, ping-ponging between res and scratch instead of allocating per pass
+void blurImg (
+    const std::vector<std::vector<std::vector<int>>> &img, int width, int height, int passes,
+    std::vector<std::vector<std::vector<int>>> &res,
+    std::vector<std::vector<std::vector<int>>> &scratch
+){
+    if (passes < 1) {
+        reshapeImage(res, width, height);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                res[y][x] = img[y][x];
+            }
+        }
+        return;
+    }
+    // An odd pass count has to start writing into res to end there
+    auto *out = (passes % 2 == 1) ? &res : &scratch;
+    auto *other = (passes % 2 == 1) ? &scratch : &res;
+    gaussianBlur(img, width, height, *out);
+    for (int i = 1; i < passes; i++) {
+        gaussianBlur(*out, width, height, *other);
+        std::swap(out, other);
+    }
+}
+
+#endif
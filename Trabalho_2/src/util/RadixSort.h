@@ -0,0 +1,125 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Stable LSD radix sort on a 64-bit key, 8 bits per pass, on the thread pool
+//
+// Each pass counts digits per chunk, turns the counts into per-chunk offsets
+// and scatters in parallel; chunks keep their order, so the sort is stable.
+// Passes where every key has the same digit are skipped (e.g. the high bits of
+// small integers, or the low mantissa bits of weights with few distinct values).
+
+namespace radix_sort {
+
+// Bits of a double that order like the double (negatives included)
+inline uint64_t sortable_bits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+}
+
+// Bits of a float that order like the float (negatives included)
+inline uint32_t sortable_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+namespace detail {
+
+// The passes shared by sort() and sort_keys(): keys are sorted in place and
+// scatter(from, to) / commit() move whatever travels with them
+template <typename Scatter, typename Commit>
+void passes(std::vector<uint64_t>& keys, ThreadPool& pool, Scatter scatter, Commit commit, int from_bit = 0) {
+    constexpr int RADIX = 256;
+    int total = static_cast<int>(keys.size());
+    int chunk = std::max(16384, (total + pool.size() * 4 - 1) / (pool.size() * 4));
+    int chunk_count = (total + chunk - 1) / chunk;
+    std::vector<uint64_t> keys_out(total);
+    std::vector<std::array<int, RADIX>> count(chunk_count);
+
+    for (int shift = from_bit; shift < 64; shift += 8) {
+        pool.parallel_for(0, chunk_count, [&](int lo, int hi) {
+            for (int c = lo; c < hi; c++) {
+                count[c].fill(0);
+                int end = std::min(total, (c + 1) * chunk);
+                for (int i = c * chunk; i < end; i++) {
+                    count[c][(keys[i] >> shift) & (RADIX - 1)]++;
+                }
+            }
+        }, 1);
+
+        // Digit-major, chunk-minor prefix sums
+        int offset = 0;
+        bool constant = false;
+        for (int d = 0; d < RADIX; d++) {
+            int digit_total = 0;
+            for (int c = 0; c < chunk_count; c++) {
+                int n = count[c][d];
+                count[c][d] = offset;
+                offset += n;
+                digit_total += n;
+            }
+            if (digit_total == total) {
+                constant = true;
+            }
+        }
+        if (constant) {
+            continue;
+        }
+
+        pool.parallel_for(0, chunk_count, [&](int lo, int hi) {
+            for (int c = lo; c < hi; c++) {
+                int end = std::min(total, (c + 1) * chunk);
+                for (int i = c * chunk; i < end; i++) {
+                    int to = count[c][(keys[i] >> shift) & (RADIX - 1)]++;
+                    keys_out[to] = keys[i];
+                    scatter(i, to);
+                }
+            }
+        }, 1);
+        keys.swap(keys_out);
+        commit();
+    }
+}
+
+}
+
+template <typename Item, typename KeyFn>
+void sort(std::vector<Item>& items, KeyFn key, ThreadPool& pool = ThreadPool::shared()) {
+    int total = static_cast<int>(items.size());
+    if (total < 2) {
+        return;
+    }
+    std::vector<uint64_t> keys(total);
+    pool.parallel_for(0, total, [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++) {
+            keys[i] = key(items[i]);
+        }
+    });
+    std::vector<Item> items_out(total);
+    detail::passes(keys, pool,
+                   [&](int from, int to) { items_out[to] = std::move(items[from]); },
+                   [&]() { items.swap(items_out); });
+}
+
+// Sorts the keys themselves, with nothing moved alongside: pack the payload
+// (e.g. an index) into the low bits to get a permutation out of a key-only sort.
+// Bits below from_bit are taken as already in order (an index packed in the
+// low 32 bits of keys built in index order needs from_bit = 32)
+inline void sort_keys(std::vector<uint64_t>& keys, ThreadPool& pool = ThreadPool::shared(), int from_bit = 0) {
+    if (keys.size() < 2) {
+        return;
+    }
+    detail::passes(keys, pool, [](int, int) {}, []() {}, from_bit);
+}
+
+}
+
+#endif
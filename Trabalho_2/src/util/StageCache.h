@@ -0,0 +1,161 @@
+#ifndef STAGE_CACHE_H
+#define STAGE_CACHE_H
+
+#include "Ppm.h"
+#include "../graph/GraphFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// Content-addressed cache of preprocessing results
+//
+// An entry is a directory named after the hash of the input bytes and of the
+// parameters of the stages that produced it; same input + same parameters means
+// the stored planes and graph can be used as they are. The directory's mtime is
+// its last use, and the least recently used entries are removed once the cache
+// grows past max_bytes.
+class StageCache {
+
+private:
+
+    std::filesystem::path dir;
+    uint64_t max_bytes;
+
+    static uint64_t entry_size(const std::filesystem::path &entry) {
+        uint64_t total = 0;
+        std::error_code ec;
+        for (const auto &file : std::filesystem::directory_iterator(entry, ec)) {
+            if (file.is_regular_file(ec)) total += file.file_size(ec);
+        }
+        return total;
+    }
+
+public:
+
+    StageCache(std::filesystem::path dir, uint64_t max_bytes)
+    : dir(std::move(dir)), max_bytes(max_bytes) {
+        std::filesystem::create_directories(this->dir);
+    }
+
+    // Hex key of input bytes + a textual description of the stage parameters
+    static std::string make_key(const std::string &input_bytes, const std::string &params) {
+        uint64_t input_hash = graph_file::checksum(input_bytes.data(), input_bytes.size());
+        uint64_t params_hash = graph_file::checksum(params.data(), params.size());
+        std::ostringstream key;
+        key << std::hex << input_hash << "-" << input_bytes.size() << "-" << params_hash;
+        return key.str();
+    }
+
+    // Entry directory when present (and marks it as just used), empty path otherwise
+    std::filesystem::path find(const std::string &key) {
+        std::filesystem::path entry = dir / key;
+        std::error_code ec;
+        if (!std::filesystem::is_directory(entry, ec)) {
+            return {};
+        }
+        std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), ec);
+        return entry;
+    }
+
+    // Empty directory to write a new entry into; publish() makes it visible
+    std::filesystem::path prepare(const std::string &key) {
+        std::filesystem::path staging = dir / (key + ".tmp");
+        std::filesystem::remove_all(staging);
+        std::filesystem::create_directories(staging);
+        return staging;
+    }
+
+    // Atomically renames the staging directory, then trims the cache
+    void publish(const std::string &key) {
+        std::filesystem::path entry = dir / key;
+        std::error_code ec;
+        std::filesystem::remove_all(entry, ec);
+        std::filesystem::rename(dir / (key + ".tmp"), entry, ec);
+        evict(key);
+    }
+
+    // Removes least recently used entries until the total fits (never `keep`)
+    void evict(const std::string &keep = "") {
+        struct Entry {
+            std::filesystem::path path;
+            std::filesystem::file_time_type used;
+            uint64_t bytes;
+        };
+        std::vector<Entry> entries;
+        uint64_t total = 0;
+        std::error_code ec;
+        for (const auto &item : std::filesystem::directory_iterator(dir, ec)) {
+            if (!item.is_directory(ec) || item.path().extension() == ".tmp") continue;
+            Entry entry{item.path(), std::filesystem::last_write_time(item.path(), ec), entry_size(item.path())};
+            total += entry.bytes;
+            entries.push_back(entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+            return a.used < b.used;
+        });
+        for (const Entry &entry : entries) {
+            if (total <= max_bytes) break;
+            if (entry.path.filename() == keep) continue;
+            std::filesystem::remove_all(entry.path, ec);
+            total -= entry.bytes;
+        }
+    }
+
+    // Raw int32 image, `channels` of the 3 stored (a gradient plane needs only one)
+    static bool write_image(const std::filesystem::path &path,
+                            const std::vector<std::vector<std::vector<int>>> &image,
+                            int width, int height, int channels) {
+        std::vector<int32_t> data;
+        data.reserve((size_t)width * height * channels);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                for (int c = 0; c < channels; c++) data.push_back(image[y][x][c]);
+            }
+        }
+        int32_t header[3] = {width, height, channels};
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(data.data()), data.size() * sizeof(int32_t));
+        return static_cast<bool>(file);
+    }
+
+    // Single-channel images are replicated into all 3 channels
+    static bool read_image(const std::filesystem::path &path,
+                           std::vector<std::vector<std::vector<int>>> &image,
+                           int width, int height) {
+        std::ifstream file(path, std::ios::binary);
+        int32_t header[3];
+        if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) ||
+            header[0] != width || header[1] != height || header[2] < 1 || header[2] > 3) {
+            return false;
+        }
+        int channels = header[2];
+        std::vector<int32_t> data((size_t)width * height * channels);
+        if (!file.read(reinterpret_cast<char *>(data.data()), data.size() * sizeof(int32_t))) {
+            return false;
+        }
+        reshapeImage(image, width, height);
+        size_t i = 0;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                for (int c = 0; c < 3; c++) image[y][x][c] = data[i + std::min(c, channels - 1)];
+                i += channels;
+            }
+        }
+        return true;
+    }
+
+    static std::string read_bytes(const std::filesystem::path &path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads
+// parallel_for splits [begin, end) in chunks; the calling thread also runs chunks,
+// so nested parallel_for calls from inside a task never deadlock
+class ThreadPool {
+
+private:
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    struct LoopState {
+        std::function<void(int, int)> body;
+        int begin;
+        int end;
+        int chunk;
+        int chunk_count;
+        std::atomic<int> next_chunk{0};
+        std::atomic<int> finished_chunks{0};
+        std::mutex done_mutex;
+        std::condition_variable done;
+    };
+
+    // Runs chunks until none is left; returns when this thread has nothing else to claim
+    static void run_chunks(LoopState& state) {
+        int c;
+        while ((c = state.next_chunk.fetch_add(1)) < state.chunk_count) {
+            int lo = state.begin + c * state.chunk;
+            int hi = std::min(state.end, lo + state.chunk);
+            state.body(lo, hi);
+            if (state.finished_chunks.fetch_add(1) + 1 == state.chunk_count) {
+                std::lock_guard<std::mutex> lock(state.done_mutex);
+                state.done.notify_all();
+            }
+        }
+    }
+
+    void worker_loop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    void enqueue(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+public:
+
+    // threads <= 0 uses every hardware thread; the caller counts as one of them
+    explicit ThreadPool(int threads = 0)
+    : stopping(false) {
+        if (threads <= 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (int i = 1; i < threads; i++) {
+            workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator= (const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Threads that take part in a parallel_for (workers + caller)
+    int size() const {
+        return static_cast<int>(workers.size()) + 1;
+    }
+
+    // Process-wide pool shared by the algorithms
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // Pool without workers: parallel_for runs inline on the caller
+    static ThreadPool& serial() {
+        static ThreadPool pool(1);
+        return pool;
+    }
+
+    // Runs body(lo, hi) over [begin, end) in chunks of at least min_chunk elements
+    template <typename Fn>
+    void parallel_for(int begin, int end, Fn body, int min_chunk = 4096) {
+        if (end <= begin) {
+            return;
+        }
+        int total = end - begin;
+        int max_chunks = std::max(1, total / std::max(1, min_chunk));
+        int chunk_count = std::min(max_chunks, size() * 4);
+        if (chunk_count <= 1 || workers.empty()) {
+            body(begin, end);
+            return;
+        }
+
+        auto state = std::make_shared<LoopState>();
+        state->body = std::ref(body);
+        state->begin = begin;
+        state->end = end;
+        state->chunk = (total + chunk_count - 1) / chunk_count;
+        state->chunk_count = (total + state->chunk - 1) / state->chunk;
+
+        int helpers = std::min(static_cast<int>(workers.size()), state->chunk_count - 1);
+        for (int i = 0; i < helpers; i++) {
+            enqueue([state] { run_chunks(*state); });
+        }
+        run_chunks(*state);
+
+        std::unique_lock<std::mutex> lock(state->done_mutex);
+        state->done.wait(lock, [&] { return state->finished_chunks.load() == state->chunk_count; });
+    }
+
+    // Runs fn on a worker thread (or inline when the pool has no workers)
+    template <typename Fn>
+    auto submit(Fn fn) -> std::future<decltype(fn())> {
+        using Result = decltype(fn());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(fn));
+        std::future<Result> result = task->get_future();
+        if (workers.empty()) {
+            (*task)();
+        }
+        else {
+            enqueue([task] { (*task)(); });
+        }
+        return result;
+    }
+};
+
+#endif
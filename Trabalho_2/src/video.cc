@@ -0,0 +1,114 @@
+#include "lib/video.h"
+#include "util/AsyncWriter.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+void print_usage() {
+    std::cout << "Uso: video [--k K] [--threshold T] [--start N] [--out SAIDA] [ENTRADA]\n"
+              << "  ENTRADA        padrão numerado (ex.: frames/%04d.ppm) ou '-' para quadros P6\n"
+              << "                 concatenados na entrada padrão (padrão: '-')\n"
+              << "  --k K          parâmetro de Felzenszwalb (padrão: 300)\n"
+              << "  --threshold T  variação (0-255) a partir da qual um pixel conta como alterado (padrão: 8)\n"
+              << "  --start N      primeiro número do padrão de entrada (padrão: 0)\n"
+              << "  --out SAIDA    padrão numerado para os quadros segmentados, ou '-' para a saída padrão\n";
+}
+
+std::string frame_name(const std::string &pattern, int index) {
+    std::vector<char> name(pattern.size() + 32);
+    std::snprintf(name.data(), name.size(), pattern.c_str(), index);
+    return name.data();
+}
+}
+
+int main(int argc, char *argv[]) {
+    SegmentationParams params;
+    int threshold = 8;
+    int start = 0;
+    std::string input = "-";
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--k") == 0 && i + 1 < argc) {
+            params.k = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--start") == 0 && i + 1 < argc) {
+            start = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            print_usage();
+            return 0;
+        } else {
+            input = argv[i];
+        }
+    }
+
+    bool from_stdin = input == "-";
+    bool to_stdout = output == "-";
+    if (!from_stdin && input.find('%') == std::string::npos) {
+        print_usage();
+        return 1;
+    }
+    std::ios::sync_with_stdio(false);
+    // Relatório vai para stderr quando os quadros vão para stdout
+    FILE *report = to_stdout ? stderr : stdout;
+
+    VideoSegmenter segmenter(params, threshold);
+    SegmentationWorkspace &ws = segmenter.workspace();
+    AsyncWriter writer;
+
+    int frames = 0;
+    int full_frames = 0;
+    long long changed = 0;
+    long long pixels = 0;
+    double busy = 0.0;
+    auto begin = std::chrono::steady_clock::now();
+
+    while (true) {
+        bool loaded;
+        if (from_stdin) {
+            loaded = readPPM(std::cin, ws.image, ws.width, ws.height);
+        } else {
+            std::string name = frame_name(input, start + frames);
+            loaded = std::filesystem::exists(name) && loadPPM(name, ws.image, ws.width, ws.height);
+        }
+        if (!loaded) {
+            break;
+        }
+
+        auto frame_start = std::chrono::steady_clock::now();
+        segmenter.segment();
+        busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_start).count();
+
+        changed += segmenter.last_changed_pixels();
+        pixels += (long long)ws.width * ws.height;
+        full_frames += segmenter.last_was_full();
+
+        if (!output.empty()) {
+            paint_segments(ws);
+            if (to_stdout) {
+                writePPM(std::cout, ws.image, ws.width, ws.height);
+            } else {
+                writer.save(frame_name(output, start + frames), ws.image, ws.width, ws.height);
+            }
+        }
+        frames++;
+    }
+    writer.finish();
+    std::cout.flush();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    if (frames == 0) {
+        fprintf(report, "Nenhum quadro lido\n");
+        return 1;
+    }
+    fprintf(report, "Quadros: %d (%d do zero) | Tempo total: %.3lfs | %.2lf quadros/s | segmentação: %.2lf quadros/s\n",
+            frames, full_frames, wall, frames / wall, busy > 0 ? frames / busy : 0.0);
+    fprintf(report, "Pixels alterados: %.1lf%% em média\n", pixels > 0 ? 100.0 * changed / pixels : 0.0);
+    return 0;
+}